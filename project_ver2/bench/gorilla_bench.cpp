@@ -0,0 +1,202 @@
+// Đo thông lượng encode/decode của codec Gorilla (Gorilla.h) trên chuỗi mẫu tổng hợp
+// hoặc file đã ghi (segment .rec của flight recorder hoặc CSV, như chế độ replay -F).
+//
+//   gorilla_bench [-b block_samples] [-n samples] [-t seconds] [file.rec|file.csv]
+//
+// Mỗi chuỗi được nén thành các khối block_samples mẫu rồi giải nén lại; kết quả giải nén
+// được so bit-exact (f32) với đầu vào trước khi đo. MB/s tính theo kích thước frame
+// nhị phân thường (SampleFrame) của cùng số mẫu, tức lượng dữ liệu codec thay thế.
+#include "Gorilla.h"
+#include "Replay.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static double nowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Kênh thay đổi chậm, lượng tử 0.01 như cảm biến thật (góc quay đều, nhiệt độ/độ ẩm trôi dần)
+static std::vector<SampleFrame> slowStream(size_t count) {
+    std::vector<SampleFrame> frames(count);
+    std::mt19937 rng(42);
+    std::normal_distribution<double> drift(0.0, 0.02);
+    double value[CH_COUNT];
+    for (int ch = 0; ch < CH_COUNT; ++ch) value[ch] = (CHANNELS[ch].min + CHANNELS[ch].max) / 2;
+    for (size_t i = 0; i < count; ++i) {
+        SampleFrame& frame = frames[i];
+        frame.channel_mask = CHANNEL_MASK_ALL;
+        frame.sequence = (uint32_t)i;
+        frame.timestamp_us = 1000000 + i * 1667;    // 600 Hz
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            value[ch] += drift(rng);
+            if (value[ch] < CHANNELS[ch].min) value[ch] = CHANNELS[ch].min;
+            if (value[ch] > CHANNELS[ch].max) value[ch] = CHANNELS[ch].max;
+            frame.values[ch] = std::round(value[ch] * 100) / 100;
+        }
+    }
+    return frames;
+}
+
+// Nhiễu đều trong dải của từng kênh, giống bộ mô phỏng mặc định của server (trường hợp xấu)
+static std::vector<SampleFrame> noiseStream(size_t count) {
+    std::vector<SampleFrame> frames(count);
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < count; ++i) {
+        SampleFrame& frame = frames[i];
+        frame.channel_mask = CHANNEL_MASK_ALL;
+        frame.sequence = (uint32_t)i;
+        frame.timestamp_us = 1000000 + i * 1667;
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            frame.values[ch] = std::uniform_real_distribution<double>(CHANNELS[ch].min, CHANNELS[ch].max)(rng);
+        }
+    }
+    return frames;
+}
+
+static bool fileStream(const char* path, size_t limit, std::vector<SampleFrame>& frames) {
+    ReplayFile file(path);
+    if (!file.open()) return false;
+    SampleFrame frame;
+    while (frames.size() < limit && file.next(frame)) frames.push_back(frame);
+    return !frames.empty();
+}
+
+// Nén cả chuỗi thành các khối nối tiếp; trả về tổng số byte
+static size_t encodeAll(const std::vector<SampleFrame>& frames, unsigned block, std::vector<char>& out) {
+    GorillaEncoder encoder;
+    size_t used = 0;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (encoder.active() && (encoder.count() >= block || !encoder.add(frames[i]))) {
+            used += encoder.finish();
+        }
+        if (!encoder.active()) {
+            if (out.size() < used + GORILLA_BLOCK_MAX_SIZE) out.resize((used + GORILLA_BLOCK_MAX_SIZE) * 2);
+            encoder.begin(&out[used]);
+            encoder.add(frames[i]);
+        }
+    }
+    if (encoder.active()) used += encoder.finish();
+    return used;
+}
+
+// Giải nén mọi khối; trả về số mẫu, -1 nếu có khối lỗi
+static long decodeAll(const char* data, size_t len, SampleFrame* scratch, std::vector<SampleFrame>* decoded) {
+    long samples = 0;
+    size_t offset = 0;
+    while (offset < len) {
+        unsigned count = 0;
+        int n = decodeGorillaBlock(data + offset, len - offset, scratch, count);
+        if (n <= 0) return -1;
+        if (decoded) decoded->insert(decoded->end(), scratch, scratch + count);
+        samples += count;
+        offset += n;
+    }
+    return samples;
+}
+
+static bool sameAtFloat(const SampleFrame& a, const SampleFrame& b) {
+    if (a.channel_mask != b.channel_mask || a.sequence != b.sequence || a.timestamp_us != b.timestamp_us) return false;
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        if (!(a.channel_mask & channelBit(ch))) continue;
+        float x = (float)a.values[ch], y = (float)b.values[ch];
+        if (memcmp(&x, &y, sizeof(x)) != 0) return false;
+    }
+    return true;
+}
+
+static bool run(const char* name, const std::vector<SampleFrame>& frames, unsigned block, double seconds) {
+    std::vector<char> encoded;
+    size_t bytes = encodeAll(frames, block, encoded);
+
+    std::vector<SampleFrame> scratch(GORILLA_MAX_BLOCK_SAMPLES);
+    std::vector<SampleFrame> decoded;
+    decoded.reserve(frames.size());
+    if (decodeAll(encoded.data(), bytes, scratch.data(), &decoded) != (long)frames.size()) {
+        fprintf(stderr, "%s: decode failed\n", name);
+        return false;
+    }
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!sameAtFloat(frames[i], decoded[i])) {
+            fprintf(stderr, "%s: sample %zu does not round-trip\n", name, i);
+            return false;
+        }
+    }
+
+    // Lặp cả chuỗi cho đến khi đủ thời gian đo
+    size_t raw_bytes = 0;
+    for (size_t i = 0; i < frames.size(); ++i) raw_bytes += frameSize(frames[i].channel_mask);
+
+    unsigned rounds = 0;
+    size_t check = 0;
+    double start = nowSeconds(), elapsed;
+    do {
+        check += encodeAll(frames, block, encoded);
+        ++rounds;
+    } while ((elapsed = nowSeconds() - start) < seconds);
+    double encode_rate = rounds * (double)frames.size() / elapsed;
+    double encode_mb = rounds * (double)raw_bytes / elapsed / 1e6;
+
+    unsigned decode_rounds = 0;
+    long decoded_samples = 0;
+    start = nowSeconds();
+    do {
+        decoded_samples += decodeAll(encoded.data(), bytes, scratch.data(), NULL);
+        ++decode_rounds;
+    } while ((elapsed = nowSeconds() - start) < seconds);
+    double decode_rate = decoded_samples / elapsed;
+    double decode_mb = decode_rounds * (double)raw_bytes / elapsed / 1e6;
+
+    printf("%-8s %9zu %6.2f %6.2fx %9.2f %9.1f %9.2f %9.1f\n", name, frames.size(),
+           (double)bytes / frames.size(), (double)raw_bytes / bytes, encode_rate / 1e6, encode_mb,
+           decode_rate / 1e6, decode_mb);
+    return check > 0;
+}
+
+int main(int argc, char* argv[]) {
+    unsigned block = GORILLA_DEFAULT_BLOCK_SAMPLES;
+    size_t count = 36000;       // 1 phút ở 600 Hz
+    double seconds = 1.0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:n:t:")) != -1) {
+        switch (opt) {
+        case 'b': block = (unsigned)atoi(optarg); break;
+        case 'n': count = (size_t)atol(optarg); break;
+        case 't': seconds = atof(optarg); break;
+        default:
+            fprintf(stderr, "Usage: %s [-b block_samples] [-n samples] [-t seconds] [file.rec|file.csv]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (block < 2 || block > GORILLA_MAX_BLOCK_SAMPLES || count == 0) {
+        fprintf(stderr, "block must be in [2, %u], samples > 0\n", GORILLA_MAX_BLOCK_SAMPLES);
+        return 1;
+    }
+
+#ifndef __OPTIMIZE__
+    fprintf(stderr, "warning: built without optimization, configure with -DCMAKE_BUILD_TYPE=Release\n");
+#endif
+    printf("block %u samples, %.1f s per measurement\n", block, seconds);
+    printf("%-8s %9s %6s %7s %9s %9s %9s %9s\n", "stream", "samples", "B/smp", "ratio",
+           "enc Ms/s", "enc MB/s", "dec Ms/s", "dec MB/s");
+
+    bool ok = run("slow", slowStream(count), block, seconds) &&
+              run("noise", noiseStream(count), block, seconds);
+    if (ok && optind < argc) {
+        std::vector<SampleFrame> frames;
+        if (!fileStream(argv[optind], count, frames)) {
+            fprintf(stderr, "cannot read samples from %s\n", argv[optind]);
+            return 1;
+        }
+        ok = run("file", frames, block, seconds);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <pthread.h>
+
+#include "Protocol.h"
+#include "Sampler.h"
+
+// Thống kê cửa sổ trượt của một cặp (window, stride): mean/variance từ tổng chạy,
+// min/max bằng deque đơn điệu, nên mỗi mẫu tốn O(1) bất kể độ dài cửa sổ.
+// Cửa sổ là window mẫu gần nhất; mỗi kênh chỉ tính các mẫu có kênh đó trong mask
+// (replay CSV có ô trống), kết quả chỉ chứa kênh có ít nhất một mẫu trong cửa sổ.
+// Chỉ thread lấy mẫu gọi add(); kết quả công bố qua seqlock, reactor đọc bằng latest().
+class WindowAggregate {
+public:
+    WindowAggregate(int id, unsigned window, unsigned stride);
+
+    // Bắt đầu lại với cặp (window, stride) mới khi slot được dùng lại. Sequence tiếp tục
+    // từ giá trị cũ để frame đã encode của cặp trước trong reactor không bị nhầm là kết quả mới
+    void reset(unsigned window, unsigned stride);
+
+    // true nếu mẫu này hoàn thành một stride (có kết quả mới)
+    bool add(const SampleFrame& frame);
+
+    // false nếu chưa có kết quả nào
+    bool latest(AggregateFrame& frame) const;
+
+    int id() const { return index; }
+    unsigned window() const { return window_size; }
+    unsigned stride() const { return stride_size; }
+
+private:
+    // Deque đơn điệu trên vòng chỉ số mẫu, chứa tối đa window chỉ số
+    struct MonotonicQueue {
+        std::vector<uint64_t> items;
+        size_t head;
+        size_t count;
+    };
+
+    // Bỏ chỉ số đã trượt ra khỏi cửa sổ ở đầu; gọi mỗi mẫu kể cả khi kênh vắng mặt
+    void expire(MonotonicQueue& queue, uint64_t index);
+    void push(MonotonicQueue& queue, const std::vector<double>& values, uint64_t index, bool keep_max);
+    void resum(int ch);
+    void publish(const AggregateFrame& frame);
+
+    // [0] = sequence | mask << 32, [1] = timestamp_us, [2] = count, [3..] = mean/min/max/var từng kênh
+    static const int RESULT_WORDS = 3 + 4 * CH_COUNT;
+
+    int index;
+    unsigned window_size;
+    unsigned stride_size;
+
+    uint64_t total;                 // số mẫu đã nhận
+    uint32_t next_sequence;
+    std::vector<ChannelMask> masks;         // mask của từng mẫu trong vòng
+    std::vector<double> values[CH_COUNT];   // vòng window mẫu gần nhất, chỉ hợp lệ khi có trong mask
+    unsigned present[CH_COUNT];             // số mẫu có kênh trong cửa sổ
+    double sum[CH_COUNT];
+    double sum_sq[CH_COUNT];
+    MonotonicQueue min_queue[CH_COUNT];
+    MonotonicQueue max_queue[CH_COUNT];
+
+    std::atomic<uint32_t> seq;      // lẻ = đang ghi
+    std::atomic<uint64_t> result[RESULT_WORDS];
+};
+
+// Tập các WindowAggregate dùng chung cho mọi kết nối: mỗi cặp (window, stride) chỉ
+// tính một lần trên thread lấy mẫu dù có bao nhiêu subscriber. Mỗi slot đếm số subscriber;
+// khi về 0 thread lấy mẫu ngừng tính và đánh dấu slot trống, slot được dùng lại cho cặp
+// khác. Đối tượng không bị xóa nên thread lấy mẫu duyệt mảng mà không cần khóa.
+class AggregatorSet : public SampleSink {
+public:
+    static const int MAX_AGGREGATES = 16;
+    static const unsigned MAX_WINDOW = 10000;
+
+    AggregatorSet();
+    ~AggregatorSet();
+
+    // Tìm hoặc tạo aggregate cho (window, stride) và giữ một reference; NULL nếu tham số
+    // sai hoặc mọi slot đang được dùng
+    WindowAggregate* acquire(unsigned window, unsigned stride);
+    // Trả reference của acquire()
+    void release(WindowAggregate* aggregate);
+
+    // eventfd được ghi mỗi khi có kết quả mới (gọi trước khi thread lấy mẫu chạy):
+    // subscriber được đẩy theo nhịp stride của mẫu thay vì theo đồng hồ
+    void notifyOnResult(int event_fd);
+
+    void onSample(const SampleFrame& frame);
+
+    int active() const;
+
+private:
+    // ACTIVE -> RELEASED (reference cuối được trả) -> FREE (thread lấy mẫu đã ngừng dùng)
+    enum SlotState { SLOT_FREE, SLOT_ACTIVE, SLOT_RELEASED };
+
+    struct Slot {
+        WindowAggregate* aggregate;
+        unsigned refs;                  // chỉ đổi khi giữ mutex
+        std::atomic<int> state;
+    };
+
+    pthread_mutex_t mutex;
+    Slot slots[MAX_AGGREGATES];
+    std::atomic<int> count;             // số slot đã từng dùng, thread lấy mẫu chỉ duyệt chừng này
+    std::vector<int> notify_fds;
+};
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <cstdint>
+
+// Số lần operator new được gọi trên thread hiện tại (AllocCounter.cpp thay thế
+// operator new/delete toàn cục của server). Dùng để kiểm chứng hot path không cấp phát.
+uint64_t threadAllocations();
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef CHANNELS_H
+#define CHANNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Schema kênh duy nhất: mỗi dòng X(enum, tag, tên, min, max, scale, offset) là một kênh,
+// theo thứ tự bit trong channel mask. Enum, tag text ("AZ:"), dải giá trị của bộ mô phỏng,
+// hiệu chuẩn mặc định của DeviceSource (giá trị = (raw + offset) * scale với raw int16),
+// bảng tra tag và codec nhị phân từng kênh (Protocol.cpp) đều sinh từ danh sách này;
+// thêm kênh chỉ cần thêm một dòng. Tag là hai chữ cái in hoa.
+#define ZTURN_CHANNELS(X)                                                   \
+    X(CH_AZIMUTH,     AZ, "azimuth",     0.0,  360.0, 360.0 / 32768, 0.0)   \
+    X(CH_ELEVATION,   EL, "elevation",   0.0,  90.0,  90.0 / 32768,  0.0)   \
+    X(CH_TEMPERATURE, TE, "temperature", 20.0, 30.0,  0.01,          0.0)   \
+    X(CH_HUMIDITY,    HU, "humidity",    40.0, 80.0,  0.01,          0.0)
+
+enum Channel {
+#define ZTURN_CHANNEL_ENUM(id, tag, name, lo, hi, scale, offset) id,
+    ZTURN_CHANNELS(ZTURN_CHANNEL_ENUM)
+#undef ZTURN_CHANNEL_ENUM
+    CH_COUNT
+};
+
+// Bit i = có kênh i. Trên dây mask chiếm (CH_COUNT + 7) / 8 byte (Protocol.h).
+typedef uint32_t ChannelMask;
+static_assert(CH_COUNT >= 1 && CH_COUNT <= 32, "channel mask is at most 32 bits");
+
+const ChannelMask CHANNEL_MASK_ALL = (ChannelMask)(~0ull >> (64 - CH_COUNT));
+
+inline ChannelMask channelBit(int ch) {
+    return (ChannelMask)1 << ch;
+}
+
+struct ChannelInfo {
+    const char* tag;
+    const char* name;
+    double min;     // dải giá trị của bộ mô phỏng
+    double max;
+    double scale;   // hiệu chuẩn mặc định cho bản ghi int16 của thiết bị
+    double offset;
+};
+
+const ChannelInfo CHANNELS[CH_COUNT] = {
+#define ZTURN_CHANNEL_INFO(id, tag, name, lo, hi, scale, offset) { #tag, name, lo, hi, scale, offset },
+    ZTURN_CHANNELS(ZTURN_CHANNEL_INFO)
+#undef ZTURN_CHANNEL_INFO
+};
+
+// Tra kênh từ hai ký tự tag bằng một bảng 26×26 (O(1), không phụ thuộc số kênh).
+// Trả -1 nếu không phải tag của kênh nào.
+inline int channelFromTag(char a, char b) {
+    struct TagTable {
+        int8_t channel[26 * 26];
+        TagTable() {
+            for (int i = 0; i < 26 * 26; ++i) channel[i] = -1;
+            for (int ch = 0; ch < CH_COUNT; ++ch) {
+                channel[(CHANNELS[ch].tag[0] - 'A') * 26 + (CHANNELS[ch].tag[1] - 'A')] = (int8_t)ch;
+            }
+        }
+    };
+    static const TagTable table;
+    unsigned i = (unsigned)(a - 'A');
+    unsigned j = (unsigned)(b - 'A');
+    if (i >= 26 || j >= 26) return -1;
+    return table.channel[i * 26 + j];
+}
+
+#endif
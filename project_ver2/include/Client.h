@@ -2,11 +2,12 @@
 #define CLIENT_H
 
 #include <iostream>
-#include <list>
+#include <vector>
 #include <string>
 #include <chrono>
 #include <thread>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <arpa/inet.h>
@@ -18,31 +19,65 @@
 #include <cstring>
 #include <pthread.h>
 
-// LOG LEVEL
-//  LOG LEVEL 
-// OFF  = tắt hết log
-// INFO = chỉ log giá trị trung bình (50 mẫu)
-// DEBUG = log tất cả dữ liệu nhận được
-enum LogLevel { OFF, INFO, DEBUG };
+#include "Protocol.h"
+#include "Gorilla.h"
+#include "Logger.h"
+#include "Multicast.h"
+#include "ShmRing.h"
+#include "Stats.h"
+#include "RealTime.h"
 
-struct DataLists {
-    std::list<double> azimuth_list;
-    std::list<double> elevation_list;
-    std::list<double> temperature_list;
-    std::list<double> humidity_list;
-// dsách Lkết để lưu dữ liệu nhận được từ server
-// Client parse số đó và push vào list, đồng thời duy trì tổng để tính trung bình
-    double azimuth_sum = 0.0;
-    double elevation_sum = 0.0;
-    double temperature_sum = 0.0;
-    double humidity_sum = 0.0;
+// SAMPLE_SIZE mẫu gần nhất của mọi kênh trong schema, lưu trong một vòng đệm cố định
+// (không cấp phát khi nhận), đồng thời duy trì tổng để tính trung bình
+struct SampleWindow {
+    static const int SAMPLE_SIZE = 50; // số mẫu để tính trung bình
 
-    const int SAMPLE_SIZE = 50; // số mẫu để tính trung bình
+    double values[SAMPLE_SIZE][CH_COUNT] = {};
+    double sums[CH_COUNT] = {};
+    uint64_t added[CH_COUNT] = {};     // số giá trị đã nhận của từng kênh
+
+    void add(int channel, double value);
+    // Các kênh có trong mask của frame
+    void add(const SampleFrame& frame);
+
+    // Đủ SAMPLE_SIZE mẫu ở kênh cuối (kênh cuối của một mẫu vừa nhận xong)
+    bool full() const { return added[CH_COUNT - 1] >= (uint64_t)SAMPLE_SIZE; }
+    // "AZ=<avg> EL=<avg> ..." cho tất cả các kênh
+    void formatAverages(char* out, size_t size) const;
+};
+
+struct ClientConfig {
+    std::string server_ip = "192.168.1.3";
+    int server_port = 8080;
+    LogLevel log_level = INFO;
+    // > 0: chế độ streaming (SUBSCRIBE), server tự đẩy mẫu; 0: gửi GET_DATA định kỳ như cũ
+    int stream_rate_hz = 0;
+    // > 0: gửi "AGGREGATE <window> <stride>" và nhận thống kê cửa sổ thay cho mẫu thô
+    unsigned aggregate_window = 0;
+    unsigned aggregate_stride = 0;      // 0 = bằng window
+    // Dùng frame nhị phân (PROTOCOL BINARY) thay cho text "AZ:...\n"
+    bool binary = false;
+    // Nén luồng mẫu theo khối kiểu Gorilla (PROTOCOL GORILLA), cho luồng dài/tải lớn
+    bool gorilla = false;
+    // Gửi "POLICY <tên>" để chọn cách server xử lý khi client đọc không kịp; rỗng = mặc định của server
+    std::string policy;
+    // Nhận mẫu từ nhóm UDP multicast thay vì kết nối TCP tới server
+    std::string multicast_group;
+    int multicast_port = 9000;
+    std::string multicast_interface;
+    // Đọc mẫu từ vòng đệm /dev/shm của server cùng máy (không qua TCP)
+    std::string shm_name;
+    // Kết nối tới listener AF_UNIX của server theo path thay cho TCP
+    std::string unix_path;
+    bool unix_seqpacket = false;
+    // Chế độ real-time: timing_* cho vòng pacing GET_DATA, network_* cho thread nhận dữ liệu
+    RealTimeConfig realtime;
 };
 
 class Client {
 public:
-    Client(const std::string& ip, int port, LogLevel level = INFO); 
+    Client(const std::string& ip, int port, LogLevel level = INFO, int stream_rate_hz = 0);
+    Client(const ClientConfig& config);
     ~Client();
 //di chuyển CURRENT_LOG_LEVEL vào class dưới dạng log_level
     bool connectToServer();
@@ -53,14 +88,23 @@ private:
 // Thread xử lý dữ liệu nhận được từ server
     static void* processDataThread(void* arg);
     void processData();
+    bool connectUnix();
+    void receiveMulticast();
+    void receiveShm();
+    void logAggregate(const char* line, size_t len);
+    std::string formatJitter() const;
 
     int sock;       // chuyen sock thanh varible of class client 
                     // khi khoi tao truyen sock vao constructor or set sau khi connect
-    std::string server_ip;
-    int server_port;
-    LogLevel log_level;
+    ClientConfig config;
+    MulticastReceiver* multicast;
+    ShmRingReader* shm;
+
+    // Độ trễ thức dậy của vòng pacing GET_DATA so với lịch (ns)
+    LatencyHistogram pacing_jitter;
 
     pthread_t data_thread;
+    bool data_thread_active;    // đã tạo và chưa join
     bool running;
 };
 
@@ -0,0 +1,51 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Protocol.h"
+#include "Gorilla.h"
+
+class FramePool;
+
+const size_t SHARED_FRAME_MAX_SIZE = GORILLA_BLOCK_MAX_SIZE > AGGREGATE_MAX_SIZE
+                                         ? (GORILLA_BLOCK_MAX_SIZE > SAMPLE_MAX_SIZE ? GORILLA_BLOCK_MAX_SIZE : SAMPLE_MAX_SIZE)
+                                         : (AGGREGATE_MAX_SIZE > SAMPLE_MAX_SIZE ? AGGREGATE_MAX_SIZE : SAMPLE_MAX_SIZE);
+
+// Frame đã encode, bất biến sau khi tạo và được nhiều kết nối dùng chung.
+// Mỗi hàng đợi giữ một reference; frame trở về pool khi reference cuối được trả.
+struct SharedFrame {
+    std::atomic<int> refs;
+    FramePool* pool;
+    uint32_t sequence;
+    bool binary;
+    size_t length;
+    char data[SHARED_FRAME_MAX_SIZE];
+
+    void retain() { refs.fetch_add(1, std::memory_order_relaxed); }
+    void release();
+};
+
+// Pool frame của một reactor: tái sử dụng frame đã giải phóng nên khi ổn định
+// không còn new/delete cho mỗi tick
+class FramePool {
+public:
+    FramePool() {}
+    ~FramePool();
+
+    // Encode mẫu một lần; frame trả về có refs = 1 thuộc về người gọi
+    SharedFrame* encode(const SampleFrame& sample, bool binary);
+    SharedFrame* encodeAggregate(const AggregateFrame& aggregate, bool binary);
+    // Frame rỗng (refs = 1) để người gọi tự ghi, ví dụ khối nén riêng của một kết nối
+    SharedFrame* acquire();
+    void recycle(SharedFrame* frame);
+
+private:
+
+    std::vector<SharedFrame*> free_frames;
+};
+
+#endif
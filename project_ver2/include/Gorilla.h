@@ -0,0 +1,66 @@
+#ifndef GORILLA_H
+#define GORILLA_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Protocol.h"
+
+// Nén chuỗi mẫu theo kiểu Gorilla (Facebook, VLDB 2015): sequence và timestamp lưu
+// delta-of-delta, mỗi giá trị f32 lưu XOR với giá trị trước của cùng kênh. Các kênh
+// thay đổi chậm nên phần lớn XOR chỉ còn vài bit có nghĩa.
+//
+// Mỗi khối tự chứa (mất/bỏ một khối không ảnh hưởng khối sau):
+//   magic u16, version u8, FRAME_FLAG_GORILLA u8, sequence u32, time_us u64  (mẫu đầu), mask
+//   count u16, payload u16 (số byte bit stream)
+//   bit stream (MSB trước): mẫu đầu = 32 bit cho mỗi kênh; các mẫu sau =
+//     dod(sequence), dod(time_us), rồi XOR của từng kênh
+// dod:  '0' = 0 | '10' + 7 bit | '110' + 9 bit | '1110' + 12 bit | '1111' + 32 bit (bù 2)
+// XOR:  '0' = trùng giá trị trước | '10' + bit có nghĩa trong cửa sổ trước |
+//       '11' + 5 bit số bit 0 đầu + 5 bit (độ dài - 1) + bit có nghĩa
+const unsigned GORILLA_MAX_BLOCK_SAMPLES = 64;
+const unsigned GORILLA_DEFAULT_BLOCK_SAMPLES = 32;
+const size_t GORILLA_HEADER_SIZE = FRAME_HEADER_SIZE + 4;
+// Trường hợp xấu nhất mỗi mẫu: 2 x 36 bit dod + 44 bit cho mỗi kênh
+const size_t GORILLA_BLOCK_MAX_SIZE = GORILLA_HEADER_SIZE +
+                                      (GORILLA_MAX_BLOCK_SAMPLES * (72 + 44 * CH_COUNT) + 7) / 8;
+
+class GorillaEncoder {
+public:
+    GorillaEncoder() : out(NULL), samples(0) {}
+
+    // Bắt đầu khối mới trong out (tối thiểu GORILLA_BLOCK_MAX_SIZE byte)
+    void begin(char* out);
+    // false nếu khối đã đủ GORILLA_MAX_BLOCK_SAMPLES mẫu hoặc mask khác mẫu đầu: finish() trước
+    bool add(const SampleFrame& frame);
+    // Ghi count/payload vào header, trả về kích thước khối; encoder về trạng thái chưa begin
+    size_t finish();
+
+    bool active() const { return out != NULL; }
+    unsigned count() const { return samples; }
+
+private:
+    void writeBits(uint64_t value, int bits);
+    void writeDod(int64_t dod);
+    void writeXor(int ch, uint32_t bits);
+
+    unsigned char* out;
+    unsigned char* pos;     // byte tiếp theo của bit stream
+    uint64_t acc;           // các bit chưa đủ một byte
+    int acc_bits;
+    unsigned samples;
+    ChannelMask mask;
+    uint32_t prev_sequence;
+    uint64_t prev_time_us;
+    int64_t prev_sequence_delta;
+    int64_t prev_time_delta;
+    uint32_t prev_values[CH_COUNT];
+    int prev_leading[CH_COUNT];
+    int prev_trailing[CH_COUNT];
+};
+
+// Giải nén một khối vào frames (tối thiểu GORILLA_MAX_BLOCK_SAMPLES phần tử).
+// Trả về số byte của khối, 0 nếu chưa nhận đủ, -1 nếu khối không hợp lệ; count = số mẫu.
+int decodeGorillaBlock(const char* data, size_t len, SampleFrame* frames, unsigned& count);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "Protocol.h"
+#include "Sampler.h"
+
+// Lịch sử mẫu gần nhất trong bộ nhớ cho client kết nối lại hoặc vào muộn (GET_RANGE).
+// Lưu dạng struct-of-arrays: timestamp, sequence và từng kênh nằm trong mảng liên tục
+// riêng, nên tìm kiếm theo thời gian chỉ chạm vào mảng timestamp.
+// Một writer (thread lấy mẫu), nhiều reader không khóa: reader tự phát hiện mẫu
+// bị ghi đè trong lúc đọc như seqlock, writer không bao giờ phải chờ.
+class SampleHistory : public SampleSink {
+public:
+    // Byte cho mỗi mẫu: timestamp u64 + sequence u32 + mask + f32 mỗi kênh
+    static const size_t BYTES_PER_SAMPLE = 8 + 4 + sizeof(ChannelMask) + 4 * CH_COUNT;
+
+    // Số mẫu giữ lại = budget_bytes / BYTES_PER_SAMPLE, làm tròn xuống lũy thừa của 2
+    SampleHistory(size_t budget_bytes);
+
+    void onSample(const SampleFrame& frame);
+
+    // Khoảng chỉ số [first, last) của các mẫu có timestamp trong [from_us, to_us]
+    // (timestamp tăng dần theo chỉ số). Rỗng nếu first == last.
+    void find(uint64_t from_us, uint64_t to_us, uint64_t& first, uint64_t& last) const;
+
+    // Đọc tối đa count mẫu bắt đầu từ index; mẫu đã bị ghi đè được bỏ qua và index
+    // được dời tới mẫu đầu tiên thực sự đọc được. Trả về số mẫu đã đọc.
+    size_t read(uint64_t& index, SampleFrame* frames, size_t count) const;
+
+    size_t capacity() const { return mask + 1; }
+    size_t bytes() const { return capacity() * BYTES_PER_SAMPLE; }
+
+private:
+    uint64_t timestampAt(uint64_t index) const {
+        return timestamps[index & mask].load(std::memory_order_relaxed);
+    }
+
+    uint64_t mask;
+    std::unique_ptr<std::atomic<uint64_t>[]> timestamps;
+    std::unique_ptr<std::atomic<uint32_t>[]> sequences;
+    std::unique_ptr<std::atomic<ChannelMask>[]> masks;
+    std::unique_ptr<std::atomic<uint32_t>[]> values[CH_COUNT];     // bit của giá trị f32
+
+    std::atomic<uint64_t> head;         // số mẫu đã ghi xong
+    std::atomic<uint64_t> reserved;     // số mẫu đã bắt đầu ghi (= head, hoặc head + 1 khi đang ghi)
+};
+
+#endif
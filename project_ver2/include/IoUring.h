@@ -0,0 +1,65 @@
+#ifndef IOURING_H
+#define IOURING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <linux/io_uring.h>
+
+// Wrapper tối giản quanh syscall io_uring (không phụ thuộc liburing):
+// SQ/CQ ring mmap, lấy SQE, submit theo lô, duyệt CQE và provided buffer ring.
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+
+    // false nếu kernel không hỗ trợ io_uring (ENOSYS, EPERM do seccomp, ...)
+    bool init(unsigned entries);
+    // Đăng ký buffer ring cho multishot recv (kernel >= 5.19)
+    bool setupBufferRing(uint16_t group_id, unsigned count, unsigned buffer_size);
+
+    // NULL khi SQ đầy: gọi submit() rồi lấy lại
+    struct io_uring_sqe* getSqe();
+    // Đẩy toàn bộ SQE đang chờ trong một lần io_uring_enter, có thể chờ wait_nr CQE
+    int submit(unsigned wait_nr = 0);
+
+    struct io_uring_cqe* peekCqe();
+    void cqeSeen();
+
+    char* buffer(uint16_t bid) { return buffers + (size_t)bid * buffer_size; }
+    unsigned bufferSize() const { return buffer_size; }
+    void recycleBuffer(uint16_t bid);
+
+    static bool kernelAtLeast(int major, int minor);
+
+private:
+    int ring_fd;
+
+    void* sq_ptr;
+    size_t sq_size;
+    void* cq_ptr;
+    size_t cq_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned sq_entries;
+    unsigned sqe_tail;      // tail cục bộ, chưa publish cho kernel
+    unsigned sqe_submitted;
+
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    struct io_uring_buf_ring* buf_ring;
+    size_t buf_ring_size;
+    unsigned buf_count;
+    unsigned buffer_size;
+    char* buffers;
+};
+
+#endif
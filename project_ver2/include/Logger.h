@@ -0,0 +1,95 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <pthread.h>
+
+// LOG LEVEL
+// OFF  = tắt hết log
+// INFO = log thông tin chung và tóm tắt định kỳ (giá trị trung bình, số mẫu đã gửi)
+// DEBUG = log tất cả dữ liệu gửi/nhận
+enum LogLevel { OFF, INFO, DEBUG };
+
+// Logger bất đồng bộ: mỗi thread ghi vào ring buffer SPSC riêng (không khóa, không
+// cấp phát, không flush), một background thread gom các ring và ghi ra stdout.
+// Ring đầy thì message bị bỏ và được đếm lại, thread gọi log không bao giờ bị chặn.
+class Logger {
+public:
+    static Logger& instance();
+
+    void setLevel(LogLevel level) { current_level.store(level, std::memory_order_relaxed); }
+    bool enabled(LogLevel level) const {
+        return level != OFF && level <= current_level.load(std::memory_order_relaxed);
+    }
+
+    void log(LogLevel level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+    // Dừng background thread sau khi ghi hết các message còn lại
+    void shutdown();
+
+    // Tạo trước ring của thread gọi (ngoài đường nóng); lock = mlock vùng ring.
+    // false nếu mlock thất bại.
+    bool prepareThread(bool lock);
+
+    static const int MESSAGE_SIZE = 240;
+    static const unsigned RING_SIZE = 512;     // lũy thừa của 2
+
+private:
+    struct Record {
+        int64_t time_us;
+        uint32_t length;
+        char text[MESSAGE_SIZE];
+    };
+
+    struct Ring {
+        std::atomic<uint32_t> head;     // chỉ background thread ghi
+        std::atomic<uint32_t> tail;     // chỉ thread sở hữu ghi
+        std::atomic<uint64_t> dropped;
+        Ring* next;
+        Record records[RING_SIZE];
+    };
+
+    Logger();
+    ~Logger();
+
+    Ring* threadRing();
+    static void* drainThread(void* arg);
+    bool drain();
+
+    std::atomic<int> current_level;
+    std::atomic<Ring*> rings;           // danh sách ring, chỉ thêm vào đầu
+    std::atomic<bool> running;
+    pthread_t drain_thread;
+    char* output;                       // buffer gom output của một lần drain
+};
+
+// Giới hạn tần suất cho log tóm tắt: allow() trả true tối đa một lần mỗi interval
+class RateLimiter {
+public:
+    explicit RateLimiter(int64_t interval_ms) : interval_ns(interval_ms * 1000000), next_ns(0) {}
+    bool allow();
+
+private:
+    int64_t interval_ns;
+    std::atomic<int64_t> next_ns;
+};
+
+// Level bị tắt thì tham số không được tính, chi phí chỉ là một phép so sánh
+#define LOG_AT(level, ...) \
+    do { \
+        if (Logger::instance().enabled(level)) Logger::instance().log(level, __VA_ARGS__); \
+    } while (0)
+
+#define LOG_INFO(...) LOG_AT(INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(DEBUG, __VA_ARGS__)
+
+// Log tối đa một lần mỗi interval_ms tại mỗi vị trí gọi
+#define LOG_EVERY_MS(level, interval_ms, ...) \
+    do { \
+        static RateLimiter log_rate_limiter_(interval_ms); \
+        if (Logger::instance().enabled(level) && log_rate_limiter_.allow()) \
+            Logger::instance().log(level, __VA_ARGS__); \
+    } while (0)
+
+#endif
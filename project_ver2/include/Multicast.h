@@ -0,0 +1,66 @@
+#ifndef MULTICAST_H
+#define MULTICAST_H
+
+#include <string>
+#include <cstdint>
+#include <netinet/in.h>
+
+#include "Protocol.h"
+#include "Sampler.h"
+
+// Gửi mỗi mẫu đúng một lần (một datagram = một SampleFrame nhị phân) tới nhóm
+// multicast, tải mạng của board không phụ thuộc số consumer. Sequence trong frame
+// cho phép bên nhận phát hiện mất gói.
+class MulticastPublisher : public SampleSink {
+public:
+    MulticastPublisher(const std::string& group, int port, int ttl = 1,
+                       const std::string& interface_ip = "");
+    ~MulticastPublisher();
+
+    bool open();
+    void onSample(const SampleFrame& frame);
+
+    uint64_t sent() const { return datagrams_sent; }
+    uint64_t errors() const { return send_errors; }
+
+private:
+    std::string group;
+    int port;
+    int ttl;
+    std::string interface_ip;
+
+    int sock;
+    struct sockaddr_in dest;
+    uint64_t datagrams_sent;
+    uint64_t send_errors;
+};
+
+// Nhận frame từ nhóm multicast, theo dõi sequence để đếm số mẫu bị mất
+class MulticastReceiver {
+public:
+    MulticastReceiver(const std::string& group, int port, const std::string& interface_ip = "");
+    ~MulticastReceiver();
+
+    bool open();
+    int fd() const { return sock; }
+
+    // Đọc một datagram: 1 nếu có frame hợp lệ, 0 nếu không có dữ liệu (EAGAIN) hoặc
+    // datagram không hợp lệ, -1 nếu lỗi socket
+    int receive(SampleFrame& frame);
+
+    uint64_t received() const { return frames_received; }
+    uint64_t lost() const { return frames_lost; }
+
+private:
+    std::string group;
+    int port;
+    std::string interface_ip;
+
+    int sock;
+    bool have_sequence;
+    uint32_t last_sequence;
+    uint64_t frames_received;
+    uint64_t frames_lost;
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "Channels.h"
+
+// Frame nhị phân (little-endian, packed), dùng sau khi client gửi "PROTOCOL BINARY\n":
+//   magic    u16  0x5AA5 (byte đầu 0xA5 không phải ASCII nên không lẫn với dòng text)
+//   version  u8
+//   flags    u8   FRAME_FLAG_AGGREGATE / FRAME_FLAG_GORILLA, 0 với frame mẫu
+//   sequence u32
+//   time_us  u64  thời điểm lấy mẫu (Unix epoch, micro giây)
+//   mask     u8 × CHANNEL_MASK_BYTES  bit i = có kênh i
+//   values   f32 × popcount(mask), theo thứ tự kênh
+// Version 1 (mask u8 ở byte 3, chung với cờ, tối đa 6 kênh) vẫn giải mã được để đọc
+// các bản ghi cũ của flight recorder.
+const uint16_t FRAME_MAGIC = 0x5AA5;
+const uint8_t FRAME_MAGIC_BYTE0 = 0xA5;
+const uint8_t FRAME_VERSION = 2;
+const uint8_t FRAME_VERSION_V1 = 1;
+const size_t CHANNEL_MASK_BYTES = (CH_COUNT + 7) / 8;
+const size_t FRAME_HEADER_SIZE = 16 + CHANNEL_MASK_BYTES;
+
+const size_t FRAME_MAX_SIZE = FRAME_HEADER_SIZE + CH_COUNT * sizeof(float);
+
+struct SampleFrame {
+    ChannelMask channel_mask;
+    uint32_t sequence;
+    uint64_t timestamp_us;
+    double values[CH_COUNT];    // chỉ các kênh có trong mask là hợp lệ
+};
+
+inline size_t frameSize(ChannelMask channel_mask) {
+    return FRAME_HEADER_SIZE + __builtin_popcount(channel_mask & CHANNEL_MASK_ALL) * sizeof(float);
+}
+
+// Mask sau time_us, dùng chung cho frame mẫu, kết quả AGGREGATE và khối Gorilla
+inline void putChannelMask(unsigned char* p, ChannelMask mask) {
+    for (size_t i = 0; i < CHANNEL_MASK_BYTES; ++i) p[16 + i] = (unsigned char)(mask >> (8 * i));
+}
+
+inline ChannelMask getChannelMask(const unsigned char* p) {
+    ChannelMask mask = 0;
+    for (size_t i = 0; i < CHANNEL_MASK_BYTES; ++i) mask |= (ChannelMask)p[16 + i] << (8 * i);
+    return mask;
+}
+
+// Ghi frame vào out (cần ít nhất FRAME_MAX_SIZE byte), trả về số byte đã ghi
+size_t encodeFrame(const SampleFrame& frame, char* out);
+
+// Trả về số byte đã dùng, 0 nếu chưa đủ dữ liệu, -1 nếu header không hợp lệ
+int decodeFrame(const char* data, size_t len, SampleFrame& frame);
+
+// Định dạng text "<tag>:<v>\n" cho mỗi kênh trong mask (ví dụ "AZ:<v>\nEL:<v>\n..."), mỗi giá trị 6 chữ số thập phân
+// như std::to_string nhưng không cấp phát bộ nhớ. out cần TEXT_SAMPLE_MAX_SIZE byte.
+const size_t FIXED_MAX_SIZE = 32;
+const size_t TEXT_SAMPLE_MAX_SIZE = CH_COUNT * (3 + FIXED_MAX_SIZE + 1);
+const size_t SAMPLE_MAX_SIZE = TEXT_SAMPLE_MAX_SIZE > FRAME_MAX_SIZE ? TEXT_SAMPLE_MAX_SIZE : FRAME_MAX_SIZE;
+
+size_t formatFixed(double value, char* out);
+size_t encodeTextSample(const SampleFrame& frame, char* out);
+
+// Kết quả tổng hợp theo cửa sổ (lệnh AGGREGATE <window> <stride>): mean, min, max và
+// phương sai của count mẫu gần nhất, gửi sau mỗi stride mẫu.
+// Nhị phân: header như frame mẫu nhưng flags = FRAME_FLAG_AGGREGATE, sequence là số
+// thứ tự kết quả, time_us là thời điểm của mẫu mới nhất; tiếp theo
+//   window u16, stride u16, count u32
+//   mean, min, max, variance  f32 × 4 cho mỗi kênh có trong mask
+// Text: "AGG <window>/<stride> n=<count> AZ:<mean>,<min>,<max>,<var> EL:... TE:... HU:...\n"
+const uint8_t FRAME_FLAG_AGGREGATE = 0x80;
+const size_t AGGREGATE_HEADER_SIZE = FRAME_HEADER_SIZE + 8;
+const size_t AGGREGATE_FRAME_MAX_SIZE = AGGREGATE_HEADER_SIZE + CH_COUNT * 4 * sizeof(float);
+const size_t TEXT_AGGREGATE_MAX_SIZE = 32 + CH_COUNT * (4 + 4 * (FIXED_MAX_SIZE + 1));
+const size_t AGGREGATE_MAX_SIZE = TEXT_AGGREGATE_MAX_SIZE > AGGREGATE_FRAME_MAX_SIZE ? TEXT_AGGREGATE_MAX_SIZE
+                                                                                     : AGGREGATE_FRAME_MAX_SIZE;
+
+struct AggregateFrame {
+    ChannelMask channel_mask;
+    uint32_t sequence;
+    uint64_t timestamp_us;
+    uint16_t window;
+    uint16_t stride;
+    uint32_t count;
+    double mean[CH_COUNT];
+    double min[CH_COUNT];
+    double max[CH_COUNT];
+    double variance[CH_COUNT];
+};
+
+// Khối nén kiểu Gorilla (PROTOCOL GORILLA): nhiều mẫu liên tiếp trong một khối tự chứa,
+// định dạng trong Gorilla.h. Header như frame mẫu nhưng flags = FRAME_FLAG_GORILLA.
+const uint8_t FRAME_FLAG_GORILLA = 0x40;
+
+inline bool isGorillaBlock(const char* data, size_t len) {
+    return len >= 4 && ((unsigned char)data[3] & FRAME_FLAG_GORILLA);
+}
+
+inline bool isAggregateFrame(const char* data, size_t len) {
+    return len >= 4 && ((unsigned char)data[3] & FRAME_FLAG_AGGREGATE);
+}
+
+size_t encodeAggregateFrame(const AggregateFrame& frame, char* out);
+int decodeAggregateFrame(const char* data, size_t len, AggregateFrame& frame);
+size_t encodeTextAggregate(const AggregateFrame& frame, char* out);
+
+#endif
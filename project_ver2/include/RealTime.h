@@ -0,0 +1,45 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <cstddef>
+#include <vector>
+
+// Chế độ real-time: ghim thread vào core, chạy SCHED_FIFO, khóa bộ nhớ (mlockall) để
+// thread lấy mẫu/pacing không bị trễ do bộ lập lịch hoặc page fault.
+// Mọi bước đều "best effort": thiếu quyền (không có CAP_SYS_NICE / CAP_IPC_LOCK) hoặc core
+// không tồn tại thì chỉ cảnh báo một lần và chạy tiếp như bình thường.
+struct RealTimeConfig {
+    // Core cho thread lấy mẫu (server) hoặc thread pacing (client); -1 = không ghim
+    int timing_cpu = -1;
+    // Core cho các thread mạng: reactor i (hoặc thread nhận của client) dùng network_cpus[i % size]
+    std::vector<int> network_cpus;
+    // Ưu tiên SCHED_FIFO 1..99; 0 = giữ SCHED_OTHER
+    int timing_priority = 0;
+    int network_priority = 0;
+    // mlockall và pre-fault stack/heap
+    bool lock_memory = false;
+
+    int networkCpu(size_t index) const {
+        return network_cpus.empty() ? -1 : network_cpus[index % network_cpus.size()];
+    }
+};
+
+// "1,2,3": core đầu cho thread lấy mẫu/pacing, các core sau cho thread mạng
+bool parseRealTimeCpus(const char* arg, RealTimeConfig& config);
+// "timing[:network]": ưu tiên SCHED_FIFO
+bool parseRealTimePriorities(const char* arg, RealTimeConfig& config);
+
+// Áp dụng cho thread đang gọi; name chỉ dùng trong log. Sau lockMemory, thread còn được
+// pre-fault stack, một khối heap trong arena malloc của nó và ring log (khóa bằng mlock
+// nếu MCL_FUTURE không áp dụng được), để lần chạm đầu không xảy ra trên đường nóng.
+void applyThreadProfile(const char* name, int cpu, int priority);
+
+// mlockall và pre-fault: chạm trước prefault_stack byte stack của thread gọi và
+// prefault_heap byte heap (giữ lại cho malloc, không trả về kernel); mỗi thread gọi
+// applyThreadProfile sau đó chạm trước prefault_stack byte stack và thread_heap byte heap
+// của riêng nó. MCL_FUTURE chỉ dùng khi RLIMIT_MEMLOCK không giới hạn hoặc có
+// CAP_IPC_LOCK, để mmap lớn về sau (history, recorder) không bị lỗi; không dùng được thì
+// cảnh báo ra stderr.
+void lockMemory(size_t prefault_stack, size_t prefault_heap, size_t thread_heap);
+
+#endif
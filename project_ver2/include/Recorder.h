@@ -0,0 +1,103 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <pthread.h>
+
+#include "Protocol.h"
+#include "Sampler.h"
+
+// Định dạng file segment "flight-NNNNNN.rec" (little-endian, như frame):
+//   RecorderHeader | index (RecorderIndexEntry x index_capacity) | frame nhị phân nối tiếp
+// Mỗi RECORDER_INDEX_INTERVAL frame có một mục index (timestamp, offset) để tìm theo
+// thời gian mà không phải quét cả file. data_bytes/index_count là phần đã ghi hợp lệ.
+const uint32_t RECORDER_MAGIC = 0x4345525Au;        // "ZREC"
+const uint32_t RECORDER_VERSION = 1;
+const uint32_t RECORDER_INDEX_INTERVAL = 256;
+
+struct RecorderHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t segment;           // số thứ tự segment
+    uint32_t index_interval;
+    uint32_t index_capacity;
+    uint32_t index_count;
+    uint64_t data_offset;       // byte đầu vùng frame tính từ đầu file
+    uint64_t data_bytes;
+    uint64_t frame_count;
+    uint64_t first_timestamp_us;
+    uint64_t last_timestamp_us;
+};
+
+struct RecorderIndexEntry {
+    uint64_t timestamp_us;
+    uint64_t offset;            // tính từ data_offset
+};
+
+// Flight recorder: ghi mọi mẫu vào các segment mmap cấp phát trước. Thread lấy mẫu
+// chỉ copy frame vào vùng nhớ đã map sẵn (MAP_POPULATE, không page fault, không syscall);
+// thread nền chuẩn bị segment kế tiếp, msync phần mới ghi và đóng segment đã đầy.
+// Không có segment dự phòng khi cần xoay (đĩa chậm) thì mẫu bị bỏ và đếm, không bao giờ chờ.
+class FlightRecorder : public SampleSink {
+public:
+    // max_segments: giữ tối đa bấy nhiêu file, xóa file cũ nhất (0 = giữ tất cả). Tính cả
+    // segment đang ghi và segment dự phòng, nên tối thiểu là 2 và đĩa dùng tối đa
+    // max_segments x segment_bytes
+    FlightRecorder(const std::string& directory, size_t segment_bytes, int flush_interval_ms,
+                   unsigned max_segments);
+    ~FlightRecorder();
+
+    bool open();
+    void onSample(const SampleFrame& frame);
+
+    uint64_t recorded() const { return frames_recorded.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return frames_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Segment {
+        uint32_t number;
+        std::string path;
+        int fd;
+        char* mapping;
+        size_t size;
+        RecorderHeader* header;
+        RecorderIndexEntry* index;
+        char* data;
+        size_t data_capacity;
+        std::atomic<size_t> used;       // byte frame đã ghi (thread lấy mẫu công bố)
+        size_t synced;                  // byte đã msync (chỉ thread nền)
+    };
+
+    static void* flushThread(void* arg);
+    void runFlush();
+    Segment* createSegment();
+    void syncSegment(Segment* segment, bool final);
+    void closeSegment(Segment* segment);
+    void removeOldSegments();
+
+    std::string directory;
+    size_t segment_bytes;
+    int flush_interval_ms;
+    unsigned max_segments;
+    uint32_t next_number;
+
+    // Thread lấy mẫu ghi vào active; thread nền đặt spare và đọc current để biết
+    // segment nào đã được thay (không còn ai ghi) để đóng lại
+    Segment* active;
+    std::atomic<Segment*> current;
+    std::atomic<Segment*> spare;
+    std::vector<Segment*> open_segments;        // chỉ thread nền (và open/destructor)
+    std::vector<std::string> finished_paths;
+
+    std::atomic<uint64_t> frames_recorded;
+    std::atomic<uint64_t> frames_dropped;
+
+    pthread_t thread;
+    std::atomic<bool> running;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SensorSource.h"
+
+// Nguồn mẫu đọc từ file đã ghi thay cho bộ sinh ngẫu nhiên: segment của flight recorder
+// (flight-NNNNNN.rec) hoặc CSV "timestamp_us,azimuth,elevation,temperature,humidity"
+// (dòng không bắt đầu bằng số, ví dụ tiêu đề, được bỏ qua).
+// File được mmap và đọc tuần tự; kernel được báo đọc trước (MADV_SEQUENTIAL/WILLNEED)
+// để thread lấy mẫu không phải chờ đĩa.
+class ReplayFile : public SensorSource {
+public:
+    ReplayFile(const std::string& path);
+    ~ReplayFile();
+
+    bool open();
+    int read(SampleFrame* frames, size_t max);
+    bool rewind();
+    // Mẫu tiếp theo với timestamp gốc; false khi hết file
+    bool next(SampleFrame& frame);
+
+    SourceClock clock() const { return SOURCE_CLOCK_RECORDED; }
+    // Tần số trung bình lúc ghi, 0 nếu không xác định được
+    double rateHz() const;
+    const char* name() const { return file_path.c_str(); }
+
+    uint64_t frameCount() const { return frame_count; }
+
+private:
+    bool nextRecorded(SampleFrame& frame);
+    bool nextCsv(SampleFrame& frame);
+    void prefetch();
+
+    std::string file_path;
+    const char* mapping;
+    size_t mapping_size;
+    bool csv;
+
+    const char* begin;      // vùng dữ liệu (bỏ header của segment)
+    const char* end;
+    const char* pos;
+    const char* prefetched;     // đã báo WILLNEED tới đây
+
+    uint64_t frame_count;
+    uint64_t first_timestamp_us;
+    uint64_t last_timestamp_us;
+};
+
+#endif
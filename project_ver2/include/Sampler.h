@@ -0,0 +1,97 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <pthread.h>
+
+#include "Protocol.h"
+#include "SensorSource.h"
+#include "Stats.h"
+
+// Nhận từng mẫu mới trên thread lấy mẫu (multicast, ghi file, ...). onSample phải
+// nhanh và không chặn vì nó nằm trên đường lấy mẫu.
+class SampleSink {
+public:
+    virtual ~SampleSink() {}
+    virtual void onSample(const SampleFrame& frame) = 0;
+};
+
+// Thread lấy mẫu duy nhất: đọc từng khối mẫu từ SensorSource (mặc định bộ mô phỏng),
+// phát từng mẫu theo nhịp của nguồn và công bố mẫu mới nhất qua seqlock. Reader (các reactor) không khóa, không chặn writer; chỉ đọc lại
+// trong trường hợp hiếm khi trùng lúc writer đang ghi.
+class Sampler {
+public:
+    Sampler(double rate_hz);
+    ~Sampler();
+
+    // Công bố mẫu đầu tiên trước khi trả về, nên latest() luôn có dữ liệu sau start()
+    void start();
+    void stop();
+
+    // Chỉ đăng ký trước start()
+    void addSink(SampleSink* sink) { sinks.push_back(sink); }
+    // Thay bộ mô phỏng bằng nguồn khác đã open() (chỉ gọi trước start()). Với nguồn
+    // SOURCE_CLOCK_RECORDED, speed: 1 = đúng nhịp lúc ghi, N = nhanh gấp N lần, 0 = nhanh
+    // nhất có thể; mẫu được gán lại timestamp hiện tại để history và recorder vẫn tăng
+    // đơn điệu. loop: nguồn hết dữ liệu thì rewind() và phát lại từ đầu.
+    void setSource(SensorSource* source, double speed, bool loop);
+    // Chế độ real-time: ghim thread lấy mẫu vào cpu (-1 = không) và chạy SCHED_FIFO với
+    // priority (0 = không); áp dụng khi thread bắt đầu, chỉ gọi trước start()
+    void setThreadProfile(int cpu, int priority) {
+        thread_cpu = cpu;
+        thread_priority = priority;
+    }
+
+    void latest(SampleFrame& frame) const;
+    double rateHz() const { return rate_hz; }
+    // Độ trễ thức dậy so với thời điểm lấy mẫu dự kiến (ns), đọc được từ thread khác
+    const LatencyHistogram& jitter() const { return wakeup_jitter; }
+
+private:
+    static void* samplingThread(void* arg);
+    void run();
+    // Mẫu kế tiếp đã chờ đúng nhịp; false khi nguồn hết dữ liệu
+    bool acquire(SampleFrame& frame);
+    bool nextFromBlock(SampleFrame& frame);
+    void publish(const SampleFrame& frame);
+
+    // Payload lưu dưới dạng các word atomic (relaxed) để seqlock không có data race:
+    // [0] = sequence | mask << 32, [1] = timestamp_us, [2..] = bit của từng giá trị
+    static const int PAYLOAD_WORDS = 2 + CH_COUNT;
+    static const size_t BLOCK_SAMPLES = 64;
+
+    double rate_hz;
+    std::atomic<uint32_t> seq;      // lẻ = writer đang ghi
+    std::atomic<uint64_t> payload[PAYLOAD_WORDS];
+
+    uint32_t next_sequence;
+
+    SimulatedSource simulator;
+    SensorSource* source;
+    double speed;
+    bool loop;
+
+    SampleFrame block[BLOCK_SAMPLES];
+    size_t block_len;
+    size_t block_pos;
+
+    std::chrono::steady_clock::time_point next_tick;   // SOURCE_CLOCK_SAMPLER
+    bool rebase;                    // SOURCE_CLOCK_RECORDED: đầu dữ liệu, đặt lại mốc nhịp
+    uint64_t origin_us;             // timestamp gốc của mẫu làm mốc
+    std::chrono::steady_clock::time_point origin;
+
+    int thread_cpu;
+    int thread_priority;
+    LatencyHistogram wakeup_jitter;
+
+    std::vector<SampleSink*> sinks;
+
+    pthread_t thread;
+    std::atomic<bool> running;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef SENSOR_SOURCE_H
+#define SENSOR_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "Protocol.h"
+
+// Nhịp của nguồn quyết định cách Sampler phát các mẫu đọc được
+enum SourceClock {
+    SOURCE_CLOCK_SAMPLER,   // nguồn không có nhịp: Sampler phát theo rate_hz, timestamp = lúc phát
+    SOURCE_CLOCK_RECORDED,  // timestamp là mốc đã ghi: phát theo khoảng cách timestamp / speed
+    SOURCE_CLOCK_DEVICE     // read() tự chờ theo nhịp thiết bị, giữ nguyên timestamp lúc đo
+};
+
+// Nguồn dữ liệu cảm biến cho Sampler. read() trả một khối nhiều mẫu mỗi lần gọi để
+// chia chi phí mỗi lần đọc (syscall, sinh số, ...) cho cả khối; Sampler phát từng mẫu
+// trong khối và tự gán sequence. Chỉ được gọi trên thread lấy mẫu.
+class SensorSource {
+public:
+    virtual ~SensorSource() {}
+
+    virtual bool open() { return true; }
+    // Điền tối đa max mẫu vào frames. Trả số mẫu, 0 = chưa có dữ liệu (thử lại),
+    // -1 = hết dữ liệu hoặc lỗi
+    virtual int read(SampleFrame* frames, size_t max) = 0;
+    // Quay lại đầu dữ liệu (phát lặp); false nếu nguồn không hỗ trợ
+    virtual bool rewind() { return false; }
+
+    virtual SourceClock clock() const { return SOURCE_CLOCK_SAMPLER; }
+    // Tần số riêng của nguồn, 0 = không xác định
+    virtual double rateHz() const { return 0.0; }
+    virtual const char* name() const = 0;
+};
+
+// Bộ mô phỏng mặc định: giá trị ngẫu nhiên đều trong dải [min, max] của từng kênh trong schema
+class SimulatedSource : public SensorSource {
+public:
+    SimulatedSource();
+
+    int read(SampleFrame* frames, size_t max);
+    const char* name() const { return "simulator"; }
+
+private:
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> dist[CH_COUNT];
+};
+
+// Nguồn giả lập tất định để thử không cần phần cứng: mẫu thứ i luôn có cùng giá trị
+// (mỗi kênh là răng cưa trong dải của nó, chu kỳ khác nhau theo kênh), nên phía nhận
+// có thể tự tính giá trị mong đợi từ số mẫu đã nhận.
+class MockSource : public SensorSource {
+public:
+    MockSource();
+
+    int read(SampleFrame* frames, size_t max);
+    bool rewind() { index = 0; return true; }
+    const char* name() const { return "mock"; }
+
+    static void expected(uint64_t index, SampleFrame& frame);
+
+private:
+    uint64_t index;
+};
+
+// Hiệu chuẩn của DeviceSource cho từng kênh: giá trị = (raw + offset) * scale (quy ước IIO).
+// Mặc định lấy từ schema kênh (Channels.h)
+struct DeviceCalibration {
+    double scale[CH_COUNT];
+    double offset[CH_COUNT];
+
+    DeviceCalibration();
+};
+
+// "AZ=0.01,TE=0.1:-400": ghi đè scale[:offset] của các kênh được nêu; false nếu sai cú pháp
+bool parseDeviceCalibration(const char* arg, DeviceCalibration& calibration);
+
+// Đọc bản ghi thô từ file hoặc character device (thay cho buffer IIO của ADC trên Z-turn).
+// Mỗi bản ghi là CH_COUNT giá trị int16 little-endian, đổi ra đơn vị theo DeviceCalibration. Mỗi read() lấy cả khối bản ghi trong một syscall; timestamp của
+// khối là lúc đọc xong, các mẫu trước lùi dần theo chu kỳ lấy mẫu của thiết bị.
+// File thường (dữ liệu thiết bị đã dump ra) không tự có nhịp: Sampler phát theo rate_hz.
+class DeviceSource : public SensorSource {
+public:
+    static const size_t RECORD_SIZE = CH_COUNT * sizeof(int16_t);
+
+    DeviceSource(const std::string& path, double rate_hz,
+                 const DeviceCalibration& calibration = DeviceCalibration());
+    ~DeviceSource();
+
+    bool open();
+    int read(SampleFrame* frames, size_t max);
+    bool rewind();
+
+    SourceClock clock() const { return regular_file ? SOURCE_CLOCK_SAMPLER : SOURCE_CLOCK_DEVICE; }
+    double rateHz() const { return rate_hz; }
+    const char* name() const { return path.c_str(); }
+
+private:
+    std::string path;
+    double rate_hz;
+    int fd;
+    bool regular_file;
+    DeviceCalibration calibration;
+
+    char buffer[64 * RECORD_SIZE];
+    size_t buffered;    // byte của bản ghi dở dang từ lần đọc trước
+};
+
+#endif
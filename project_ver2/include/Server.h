@@ -6,26 +6,328 @@
 #include <random>
 #include <chrono>
 #include <thread>
+#include <vector>
+#include <atomic>
+#include <memory>
 #include <pthread.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <cstring>
 #include <fcntl.h>
+#include <errno.h>
+
+#include "Protocol.h"
+#include "AllocCounter.h"
+#include "Logger.h"
+#include "Sampler.h"
+#include "FrameBuffer.h"
+#include "Multicast.h"
+#include "ShmRing.h"
+#include "TimerWheel.h"
+#include "Aggregator.h"
+#include "Stats.h"
+#include "RealTime.h"
+#include "History.h"
+#include "Recorder.h"
+#include "Replay.h"
+#include "Slab.h"
+
+// Khi hàng đợi output của một kết nối đầy (client chậm, mạng kém)
+enum SlowConsumerPolicy {
+    POLICY_DROP_OLDEST,     // bỏ frame cũ nhất chưa gửi, giữ tối đa MAX_QUEUED_FRAMES
+    POLICY_COALESCE,        // chỉ giữ mẫu mới nhất chưa gửi
+    POLICY_DISCONNECT       // đóng kết nối
+};
+
+// Tên chính sách dùng chung cho lệnh POLICY và tùy chọn -P (không phân biệt hoa thường);
+// false nếu không phải tên hợp lệ
+bool parseSlowConsumerPolicy(const char* name, size_t len, SlowConsumerPolicy& policy);
+const char* slowConsumerPolicyName(SlowConsumerPolicy policy);
+
+struct ServerConfig {
+    int port = 8080;
+    // Số reactor thread; mỗi thread có epoll và bảng kết nối riêng
+    int num_threads = 1;
+    // Dùng backend io_uring nếu được build và kernel hỗ trợ, nếu không quay về epoll
+    bool use_io_uring = false;
+    // INFO: log kết nối và tóm tắt mỗi giây; DEBUG: log từng mẫu gửi đi
+    LogLevel log_level = INFO;
+    // Tần số của thread lấy mẫu, độc lập với số client và tần số request
+    double sample_rate_hz = 600.0;
+    // UDP multicast: nhóm rỗng = tắt; mỗi mẫu được gửi một lần tới group:port
+    std::string multicast_group;
+    int multicast_port = 9000;
+    int multicast_ttl = 1;
+    std::string multicast_interface;    // IP của interface gửi, rỗng = mặc định theo route
+    // Vòng đệm /dev/shm cho consumer cùng máy: tên rỗng = tắt
+    std::string shm_name;
+    unsigned shm_slots = 1024;
+    // Listener AF_UNIX cùng protocol với cổng TCP: path rỗng = tắt.
+    // unix_seqpacket: SOCK_SEQPACKET thay cho SOCK_STREAM (giữ ranh giới message)
+    std::string unix_path;
+    bool unix_seqpacket = false;
+    // Chính sách mặc định cho kết nối mới, client đổi bằng lệnh "POLICY ..."
+    SlowConsumerPolicy slow_consumer_policy = POLICY_DROP_OLDEST;
+    // Tổng số kết nối đồng thời, chia đều cho các reactor. Đối tượng kết nối và buffer của
+    // chúng được cấp hết khi khởi động; kết nối vượt quá bị đóng ngay sau accept
+    unsigned max_connections = 256;
+    // Đóng kết nối không gửi request và không nhận được byte nào trong khoảng này; 0 = tắt.
+    // Mặc định tắt: client chỉ thỉnh thoảng GET_DATA vẫn giữ được kết nối như trước
+    int idle_timeout_s = 0;
+    // Ghi tổng hợp bộ đếm và độ trễ của mọi reactor ra log INFO theo chu kỳ này; 0 = tắt
+    int stats_interval_s = 0;
+    // Chế độ real-time: timing_* cho thread lấy mẫu, network_* cho các reactor
+    RealTimeConfig realtime;
+    // Ngân sách bộ nhớ cho lịch sử mẫu phục vụ GET_RANGE (cấp một lần khi khởi động); 0 = tắt
+    size_t history_bytes = 16 * 1024 * 1024;
+    // Flight recorder: ghi mọi mẫu vào file segment trong thư mục này; rỗng = tắt
+    std::string recorder_dir;
+    size_t recorder_segment_bytes = 64 * 1024 * 1024;
+    int recorder_flush_ms = 1000;
+    // Số file tối đa, kể cả segment đang ghi và segment dự phòng (tối thiểu 2): đĩa dùng
+    // tối đa recorder_max_segments x recorder_segment_bytes; 0 = không xóa segment cũ
+    unsigned recorder_max_segments = 0;
+    // Nguồn cảm biến: "sim" = bộ mô phỏng ngẫu nhiên, "mock" = giá trị tất định để thử,
+    // đường dẫn khác = file/character device chứa bản ghi int16 thô (xem DeviceSource)
+    std::string sensor_source = "sim";
+    // Hiệu chuẩn int16 -> đơn vị của từng kênh cho nguồn thiết bị (mặc định theo schema kênh)
+    DeviceCalibration device_calibration;
+    // Phát lại file đã ghi (segment .rec hoặc CSV) thay cho bộ sinh ngẫu nhiên; rỗng = tắt.
+    // replay_speed: 1 = đúng nhịp lúc ghi, N = nhanh gấp N lần, 0 = nhanh nhất có thể
+    std::string replay_path;
+    double replay_speed = 1.0;
+    bool replay_loop = false;
+};
 
 class Server {
 public:
     Server(int port);
+    Server(const ServerConfig& config);
     ~Server();
 
     void start();
 
 private:
-    static void* handleClient(void* arg);
+    static const unsigned MAX_QUEUED_FRAMES = 64;
+    static const int MAX_IOV = 32;
+
+    struct Connection {
+        int fd;                   // -1: slot trống trong slab
+        std::string peer;
+        std::string in;           // phần lệnh chưa có '\n' từ lần đọc trước
+        std::string out;          // response chờ gửi
+        // Backend io_uring: buffer đang được SEND, phải giữ nguyên đến khi có CQE
+        std::string inflight;
+        size_t inflight_off;
+        size_t inflight_head;       // số byte của inflight nằm trong SENDMSG đang chạy
+        bool closing;
+        bool read_paused;         // out vượt MAX_OUT_BYTES: ngừng đọc request cho đến khi gửi bớt
+        bool evicted;             // chờ đóng: hàng đợi đầy (POLICY_DISCONNECT) hoặc idle quá lâu
+        bool binary;              // "PROTOCOL BINARY": gửi SampleFrame thay cho text
+        // "PROTOCOL GORILLA [n]": mẫu push được nén theo khối n mẫu (0 = tắt); khối đang
+        // ghi dở nằm trong gorilla_frame cho đến khi đủ mẫu
+        unsigned gorilla_block;
+        GorillaEncoder gorilla;
+        SharedFrame* gorilla_frame;
+        // SUBSCRIBE: server tự đẩy mẫu theo chu kỳ riêng của từng kết nối
+        bool subscribed;
+        int64_t push_period_ns;
+        int64_t next_push_ns;
+        // AGGREGATE: push kết quả tổng hợp dùng chung thay cho mẫu thô (NULL = mẫu thô).
+        // Kết nối giữ một reference của aggregate, trả khi đổi subscription hoặc đóng.
+        // Kết quả được đẩy khi thread lấy mẫu báo qua aggregate_fd, không dùng push_timer
+        WindowAggregate* aggregate;
+        int64_t aggregate_sent;     // sequence kết quả đã gửi gần nhất, -1 nếu chưa có
+        // GET_RANGE: đoạn lịch sử [range_next, range_end) còn phải gửi, nạp dần vào out
+        // mỗi khi socket gửi bớt để không giữ cả đoạn trong bộ nhớ
+        bool range_active;
+        uint64_t range_next;
+        uint64_t range_end;
+        ChannelMask range_mask;
+        uint64_t range_sent;
+        uint64_t range_lost;        // mẫu bị ghi đè trước khi kịp gửi
+        // Timer trong wheel của reactor; user_data = loại timer << 32 | fd
+        TimerNode push_timer;
+        TimerNode idle_timer;
+        int64_t last_activity_ns;   // lần cuối nhận request hoặc gửi được dữ liệu
+        // Số mẫu đã gửi và số lần cấp phát heap trong lúc xử lý request/push
+        uint64_t samples_sent;
+        uint64_t hot_path_allocations;
+        // Hàng đợi frame push dùng chung (vòng tròn cố định, gửi bằng sendmsg nhiều iovec)
+        SharedFrame* frames[MAX_QUEUED_FRAMES];
+        unsigned frame_head;
+        unsigned frame_count;
+        size_t frame_offset;        // số byte đã gửi của frame đầu hàng đợi
+        SlowConsumerPolicy policy;
+        uint64_t frames_dropped;
+        unsigned queue_high_water;  // số frame chờ gửi lớn nhất
+        size_t out_high_water;      // số byte response chờ gửi lớn nhất
+        // Bộ đếm của reactor sở hữu; thời điểm đọc request có response chưa gửi xong (0 = không có)
+        ThreadStats* stats;
+        int64_t request_start_ns;
+        // Backend io_uring: SENDMSG đang chạy dùng iov/msg này và frames_inflight frame đầu
+        bool send_inflight;
+        unsigned frames_inflight;
+        struct iovec iov[MAX_IOV];
+        struct msghdr msg;
+    };
+
+    // Mỗi reactor sở hữu listen socket (SO_REUSEPORT) hoặc dùng chung listener
+    // với EPOLLEXCLUSIVE, cùng epoll instance và bảng kết nối của riêng nó
+    struct Reactor {
+        Server* server;
+        int index;
+        int listen_fd;
+        int unix_fd;        // listener AF_UNIX dùng chung mọi reactor (EPOLLEXCLUSIVE), -1 nếu tắt
+        int epoll_fd;
+        int timer_fd;       // timerfd hẹn giờ cho deadline gần nhất trong wheel
+        int64_t timer_deadline_ns;  // giá trị đang đặt cho timer_fd (0 = tắt)
+        int aggregate_fd;   // eventfd: thread lấy mẫu báo có kết quả AGGREGATE mới
+        // Mọi deadline của reactor (push theo từng subscription, idle timeout)
+        TimerWheel timers;
+        std::vector<TimerNode*> expired;
+        pthread_t thread;
+        // Kết nối lấy từ slab cố định; by_fd tra fd -> kết nối (NULL nếu không thuộc reactor này)
+        Slab<Connection> connections;
+        std::vector<Connection*> by_fd;
+        std::vector<int> ready;     // kết nối có dữ liệu push cần gửi hoặc cần đóng (evicted)
+        // Mỗi mẫu chỉ encode một lần cho mỗi định dạng (text, binary) rồi dùng chung
+        FramePool frame_pool;
+        SharedFrame* cached_frames[2];
+        SharedFrame* aggregate_frames[AggregatorSet::MAX_AGGREGATES][2];
+        // Tóm tắt INFO định kỳ
+        uint64_t samples_sent;
+        uint64_t frames_encoded;
+        uint64_t frames_dropped;
+        int64_t next_summary_ns;
+        // Bộ đếm cho STATS SERVER: chỉ reactor này ghi, thread khác đọc khi tổng hợp
+        std::unique_ptr<ThreadStats> stats;
+    };
+
+    int createListenSocket(bool reuse_port);
+    int createUnixSocket();
+    void addListener(Reactor& reactor, int listen_fd, bool exclusive);
+    void setupReactors();
+    static void* reactorThread(void* arg);
+    void runReactor(Reactor& reactor);
+
+    // Event loop epoll (edge-triggered) quản lý cả listen socket và mọi client socket
+    void acceptClients(Reactor& reactor, int listen_fd);
+    bool handleClient(Reactor& reactor, int client_fd);   // false -> đóng kết nối
+    void closeClient(Reactor& reactor, int client_fd);
+    // NULL nếu slab đã đầy (client_fd đã bị đóng)
+    Connection* addConnection(Reactor& reactor, int client_fd, const char* peer);
+    void releaseConnection(Reactor& reactor, Connection& conn);
+    static Connection* findConnection(Reactor& reactor, int fd) {
+        return (size_t)fd < reactor.by_fd.size() ? reactor.by_fd[fd] : NULL;
+    }
+    const char* peerName(const struct sockaddr_storage& address);
+
+    // Xử lý request chung cho mọi backend: tách từng dòng lệnh (kể cả nhiều lệnh trong
+    // một lần đọc hoặc một lệnh bị chia qua nhiều lần đọc), response được nối vào conn.out
+    void handleRequest(Reactor& reactor, Connection& conn, const char* data, size_t len);
+    void handleCommand(Reactor& reactor, Connection& conn, const char* line, size_t len);
+
+    // Bảng lệnh: tên lệnh -> handler nhận phần tham số (không copy, không kết thúc '\0')
+    typedef void (Server::*CommandHandler)(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    struct Command {
+        const char* name;
+        CommandHandler handler;
+    };
+    static const Command COMMANDS[];
+
+    void cmdGetData(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    void cmdSubscribe(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    void cmdAggregate(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    void cmdGetRange(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    void cmdUnsubscribe(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    void cmdProtocol(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    void cmdPolicy(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    void cmdStats(Reactor& reactor, Connection& conn, const char* args, size_t len);
+    void appendSample(Reactor& reactor, Connection& conn);
+    void logSummary(Reactor& reactor);
+    // Tổng hợp ThreadStats của mọi reactor; thread nền ghi ra log theo stats_interval_s
+    void snapshotStats(StatsSnapshot& snapshot) const;
+    static void* statsThread(void* arg);
+    void runStatsDump();
+    // Response đã được kernel nhận hết: ghi độ trễ từ lúc đọc request
+    void responseSent(Connection& conn);
+    void sendPending(Connection& conn);
+    // Nạp tiếp dữ liệu GET_RANGE vào out (tối đa RANGE_CHUNK_BYTES chờ gửi)
+    void fillRange(Connection& conn);
+    // Ghi sau khi socket gửi được tiếp (EPOLLOUT); false -> đóng kết nối
+    bool handleWritable(Reactor& reactor, int client_fd);
+
+    // Fan-out: frame dùng chung được xếp vào hàng đợi của từng kết nối
+    SharedFrame* sharedFrame(Reactor& reactor, const SampleFrame& sample, bool binary);
+    // Kết quả AGGREGATE mới chưa gửi cho conn, NULL nếu chưa có
+    SharedFrame* aggregateFrame(Reactor& reactor, Connection& conn);
+    // Đẩy kết quả mới cho mọi subscriber AGGREGATE của reactor (fd được đưa vào reactor.ready)
+    void pushAggregates(Reactor& reactor);
+    void releaseAggregate(Connection& conn);
+    // Xếp frame vào hàng đợi và đưa fd vào reactor.ready; owned: trả reference của người gọi.
+    // false nếu kết nối bị ngắt vì không đọc kịp
+    bool pushFrame(Reactor& reactor, Connection& conn, SharedFrame* frame, bool owned);
+    // Thêm mẫu vào khối nén của conn; trả về khối đã đủ (người gọi giữ reference) hoặc NULL
+    SharedFrame* gorillaFrame(Reactor& reactor, Connection& conn, const SampleFrame& sample);
+    SharedFrame* finishGorillaBlock(Connection& conn);
+    void flushGorilla(Reactor& reactor, Connection& conn);
+    bool queueFrame(Reactor& reactor, Connection& conn, SharedFrame* frame);   // false -> ngắt kết nối
+    unsigned dropQueuedFrames(Connection& conn, unsigned keep);
+    int gatherOutput(Connection& conn, const char* head, size_t head_len);
+    void consumeFrames(Connection& conn, size_t bytes);
+    void releaseFrames(Connection& conn);
+    void logDisconnect(const Connection& conn);
+
+    // Xử lý timer đến hạn: push cho subscriber, đóng kết nối idle (fd được đưa vào
+    // reactor.ready, kết nối cần đóng có evicted = true) rồi hẹn lại timerfd
+    enum TimerKind { TIMER_PUSH = 1, TIMER_IDLE = 2 };
+    void runTimers(Reactor& reactor);
+    void armTimer(Reactor& reactor);
+    void cancelTimers(Reactor& reactor, Connection& conn);
+    static int64_t nowNs();
+
+    // Backend io_uring (ServerUring.cpp); false nếu không chạy được -> dùng epoll
+    bool runUringReactor(Reactor& reactor);
+
+    static const int MAX_EVENTS = 64;
+    static const size_t OUT_BUFFER_RESERVE = 4096;
+    static const size_t MAX_OUT_BYTES = 64 * 1024;
+    static const size_t MAX_LINE_LENGTH = 256;
+    static const size_t IN_BUFFER_RESERVE = MAX_LINE_LENGTH + 2048;  // phần dư + một lần đọc (kể cả buffer io_uring)
+    // fd được cấp từ số nhỏ nhất còn trống nên fd của kết nối < tổng số kết nối + số fd khác
+    // của tiến trình; bảng by_fd chỉ phải nới khi tiến trình giữ nhiều fd khác hơn mức này
+    static const size_t FD_TABLE_SLACK = 64;
+    static const int64_t TIMER_TICK_NS = 100000;     // độ phân giải của timer wheel (100 us)
+    static const int MAX_SUBSCRIBE_HZ = 10000;
+    // Chu kỳ push tối đa ~17 phút: 1e9 / rate luôn nằm trong int64 và deadline không tràn
+    static constexpr double MIN_SUBSCRIBE_HZ = 0.001;
+    static const size_t RANGE_CHUNK_BYTES = 16 * 1024;
+    static const size_t RANGE_BATCH = 64;
+    static const size_t REALTIME_PREFAULT_STACK = 256 * 1024;
+    static const size_t REALTIME_PREFAULT_HEAP = 8 * 1024 * 1024;
+    static const size_t REALTIME_PREFAULT_THREAD_HEAP = 1024 * 1024;
 
-    int server_fd;
-    int port;
+    ServerConfig config;
+    std::vector<Reactor> reactors;
+    bool shared_listener;
+    int unix_listener;
+    Sampler sampler;
+    AggregatorSet aggregates;
+    std::unique_ptr<SampleHistory> history;
+    std::unique_ptr<FlightRecorder> recorder;
+    std::unique_ptr<SensorSource> source;
+    std::unique_ptr<MulticastPublisher> multicast;
+    std::unique_ptr<ShmRingWriter> shm_ring;
+    pthread_t stats_thread;
+    std::atomic<bool> stats_running;
 };
 
 #endif
@@ -0,0 +1,75 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+#include "Protocol.h"
+#include "Sampler.h"
+
+// Vòng đệm trong /dev/shm cho consumer cùng máy: một writer (thread lấy mẫu của
+// server), nhiều reader. Mỗi slot có seqlock riêng nên reader chậm không bao giờ
+// chặn writer; reader tự phát hiện khi bị ghi đè (overrun) và nhảy tới mẫu còn giữ.
+// Đánh thức qua futex trên vùng nhớ chung, writer chỉ gọi FUTEX_WAKE khi có reader đang ngủ.
+
+struct ShmRingHeader;
+struct ShmRingSlot;
+
+class ShmRingWriter : public SampleSink {
+public:
+    // name dạng "/zturn" (tự thêm '/' nếu thiếu); slots làm tròn lên lũy thừa của 2
+    ShmRingWriter(const std::string& name, unsigned slots = 1024);
+    ~ShmRingWriter();
+
+    bool open();
+    void onSample(const SampleFrame& frame);
+
+    uint64_t published() const;
+    const std::string& path() const { return name; }
+
+private:
+    std::string name;
+    unsigned capacity;
+
+    void* mapping;
+    size_t mapping_size;
+    ShmRingHeader* header;
+    ShmRingSlot* slots;
+};
+
+class ShmRingReader {
+public:
+    ShmRingReader(const std::string& name);
+    ~ShmRingReader();
+
+    // Bắt đầu từ mẫu mới nhất đang có trong ring
+    bool open();
+
+    // 1 nếu đọc được một mẫu, 0 nếu chưa có mẫu mới. Không có syscall.
+    int read(SampleFrame& frame);
+    // Chờ mẫu mới tối đa timeout_ms (spin ngắn rồi futex); false nếu hết thời gian
+    bool wait(int timeout_ms);
+
+    uint64_t received() const { return frames_received; }
+    uint64_t lost() const { return frames_lost; }
+    uint64_t overruns() const { return overrun_count; }
+
+private:
+    void skipTo(uint64_t index);
+
+    std::string name;
+
+    void* mapping;
+    size_t mapping_size;
+    ShmRingHeader* header;
+    ShmRingSlot* slots;
+    uint64_t mask;
+
+    uint64_t next;          // chỉ số mẫu tiếp theo cần đọc
+    uint64_t frames_received;
+    uint64_t frames_lost;
+    uint64_t overrun_count;
+};
+
+#endif
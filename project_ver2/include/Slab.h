@@ -0,0 +1,56 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Slab dung lượng cố định: mọi đối tượng được cấp một lần trong một mảng liên tục lúc
+// init(), acquire/release chỉ lấy/trả chỉ số trong free list nên không cấp phát heap.
+// Slot vừa trả được dùng lại trước (LIFO): đối tượng đang sống dồn về đầu mảng và slot
+// lấy ra thường vẫn còn nóng trong cache. Đối tượng không bị hủy khi release, người dùng
+// tự đặt lại trạng thái (nhờ vậy buffer bên trong giữ nguyên capacity giữa các lần dùng).
+// Không thread-safe: mỗi reactor có slab riêng.
+template <class T>
+class Slab {
+public:
+    Slab() : capacity_(0), high_water(0) {}
+
+    void init(size_t capacity) {
+        objects.reset(new T[capacity]);
+        capacity_ = capacity;
+        high_water = 0;
+        free_slots.resize(capacity);
+        // Slot 0 ở cuối free list để được lấy đầu tiên
+        for (size_t i = 0; i < capacity; ++i) free_slots[i] = (uint32_t)(capacity - 1 - i);
+    }
+
+    // NULL khi đã hết slot
+    T* acquire() {
+        if (free_slots.empty()) return NULL;
+        uint32_t slot = free_slots.back();
+        free_slots.pop_back();
+        if (slot >= high_water) high_water = slot + 1;
+        return &objects[slot];
+    }
+
+    void release(T* object) {
+        // Không cấp phát: free list đã có sẵn capacity cho mọi slot
+        free_slots.push_back((uint32_t)(object - objects.get()));
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return capacity_ - free_slots.size(); }
+    // Số slot đầu mảng từng được dùng; duyệt [0, highWater()) là đủ để gặp mọi đối tượng đang sống
+    size_t highWater() const { return high_water; }
+    T& operator[](size_t slot) { return objects[slot]; }
+
+private:
+    std::unique_ptr<T[]> objects;
+    std::vector<uint32_t> free_slots;
+    size_t capacity_;
+    size_t high_water;
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bộ đếm của một reactor. Mỗi ThreadStats chỉ có một thread ghi (reactor sở hữu) nên
+// cập nhật là load + store relaxed, không có lệnh atomic read-modify-write hay khóa;
+// thread khác chỉ đọc khi cần tổng hợp (STATS SERVER, dump định kỳ).
+enum StatCounter {
+    STAT_ACCEPTED,
+    STAT_REJECTED,          // kết nối bị đóng ngay sau accept vì slab đã đầy
+    STAT_REQUESTS,          // số lệnh đã xử lý
+    STAT_BYTES_IN,
+    STAT_BYTES_OUT,
+    STAT_SENDS,             // số lần sendmsg / SENDMSG hoàn tất
+    STAT_SEND_EAGAIN,
+    STAT_SEND_ERRORS,
+    STAT_FRAMES_DROPPED,
+    STAT_CONNECTIONS,       // gauge: kết nối đang mở
+    STAT_QUEUED_FRAMES,     // gauge: frame push đang chờ gửi trên mọi kết nối
+    STAT_QUEUE_HIGH_WATER,  // lớn nhất: số frame chờ gửi của một kết nối
+    STAT_COUNTERS
+};
+
+extern const char* const STAT_COUNTER_NAMES[STAT_COUNTERS];
+
+// Histogram độ trễ kiểu HDR: 2^SUB_BITS bucket tuyến tính cho giá trị nhỏ, sau đó mỗi
+// khoảng [2^k, 2^(k+1)) chia thành 2^(SUB_BITS-1) bucket, sai số tương đối ≤ 1/32.
+// Giá trị tính bằng ns, lớn hơn 2^MAX_BITS (~18 phút) được dồn vào bucket cuối.
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 6;
+    static const int MAX_BITS = 40;
+    static const int HALF = 1 << (SUB_BITS - 1);
+    static const int BUCKETS = (MAX_BITS - SUB_BITS + 2) * HALF;
+
+    LatencyHistogram();
+
+    void record(uint64_t ns);
+    uint64_t max() const { return max_ns.load(std::memory_order_relaxed); }
+    // Cộng dồn số đếm vào counts[BUCKETS] của snapshot
+    void addTo(uint64_t* counts) const;
+
+    static int bucketOf(uint64_t ns);
+    static uint64_t bucketUpper(int bucket);    // giá trị lớn nhất thuộc bucket
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<uint64_t> max_ns;
+};
+
+class ThreadStats {
+public:
+    ThreadStats();
+
+    void add(StatCounter counter, uint64_t n = 1) {
+        values[counter].store(values[counter].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    void sub(StatCounter counter, uint64_t n) {
+        values[counter].store(values[counter].load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+    }
+    void raise(StatCounter counter, uint64_t value) {
+        if (value > values[counter].load(std::memory_order_relaxed)) {
+            values[counter].store(value, std::memory_order_relaxed);
+        }
+    }
+    uint64_t get(StatCounter counter) const { return values[counter].load(std::memory_order_relaxed); }
+
+    // Từ lúc đọc request đến lúc toàn bộ response đã được kernel nhận
+    LatencyHistogram latency;
+
+private:
+    std::atomic<uint64_t> values[STAT_COUNTERS];
+};
+
+// Tổng hợp của một hoặc nhiều LatencyHistogram tại một thời điểm
+struct LatencySnapshot {
+    uint64_t counts[LatencyHistogram::BUCKETS];
+    uint64_t max_ns;
+
+    LatencySnapshot();
+    void add(const LatencyHistogram& histogram);
+    uint64_t count() const;
+    // Giá trị ns tại phân vị q (0..1), cận trên của bucket chứa nó
+    uint64_t percentile(double q) const;
+    // "count=.. p50_us=.. p90_us=.. p99_us=.. p999_us=.. max_us=..", không kết thúc '\n'
+    size_t format(char* out, size_t size) const;
+};
+
+// Tổng hợp của nhiều ThreadStats tại một thời điểm
+struct StatsSnapshot {
+    uint64_t values[STAT_COUNTERS];
+    LatencySnapshot latency;
+
+    StatsSnapshot();
+    void add(const ThreadStats& stats);
+    // "<name>=<value> ..." cho mọi bộ đếm, trả số byte đã ghi (không kết thúc '\n')
+    size_t formatCounters(char* out, size_t size) const;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Node hẹn giờ nằm sẵn trong đối tượng sở hữu (intrusive): arm/cancel không cấp phát.
+// Đối tượng chứa node phải cancel() trước khi bị hủy.
+struct TimerNode {
+    TimerNode* prev;
+    TimerNode* next;
+    uint64_t expires;       // tick hết hạn
+    uint64_t user_data;     // do người dùng đặt, wheel không đọc
+    int level;              // -1: chưa được arm
+    int slot;
+
+    TimerNode() : prev(NULL), next(NULL), expires(0), user_data(0), level(-1), slot(0) {}
+    bool armed() const { return level >= 0; }
+};
+
+// Timer wheel phân cấp (4 tầng x 256 slot): schedule/cancel O(1), số timer không
+// ảnh hưởng chi phí mỗi tick. Tầng 0 có độ phân giải tick_ns, mỗi tầng trên gấp 256 lần;
+// timer ở tầng trên được chuyển (cascade) xuống dần khi gần tới hạn.
+// Không thread-safe: mỗi reactor có wheel riêng.
+class TimerWheel {
+public:
+    TimerWheel(int64_t tick_ns = 100000);
+
+    // Đặt mốc thời gian bắt đầu, gọi một lần trước khi dùng
+    void reset(int64_t now_ns);
+
+    // Hẹn node hết hạn tại deadline_ns (làm tròn lên theo tick, không bao giờ sớm hơn)
+    void schedule(TimerNode* node, int64_t deadline_ns);
+    void cancel(TimerNode* node);
+
+    // Chuyển các node đã tới hạn vào expired (không xóa expired trước); node trả về đã được gỡ khỏi wheel
+    void advance(int64_t now_ns, std::vector<TimerNode*>& expired);
+
+    // Thời điểm (ns) cần gọi advance() tiếp theo, 0 nếu không còn timer
+    int64_t nextDeadline() const;
+
+    size_t size() const { return count; }
+
+private:
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 8;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const uint64_t SLOT_MASK = SLOTS - 1;
+
+    void insert(TimerNode* node);
+    void cascade(int level, int slot);
+    static int nextSlot(const uint64_t* bits, int from);
+
+    int64_t tick_ns;
+    uint64_t next_tick;     // tick chưa xử lý nhỏ nhất
+    size_t count;
+    TimerNode* slots[LEVELS][SLOTS];
+    uint64_t occupied[LEVELS][SLOTS / 64];      // bitmap slot khác rỗng
+};
+
+#endif
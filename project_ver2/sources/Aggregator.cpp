@@ -0,0 +1,260 @@
+#include "Aggregator.h"
+
+#include <cstring>
+#include <unistd.h>
+
+WindowAggregate::WindowAggregate(int id, unsigned window, unsigned stride)
+    : index(id), next_sequence(0), seq(0) {
+    reset(window, stride);
+}
+
+void WindowAggregate::reset(unsigned window, unsigned stride) {
+    window_size = window;
+    stride_size = stride;
+    total = 0;
+    masks.assign(window, 0);
+    seq.store(0, std::memory_order_relaxed);
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        values[ch].assign(window, 0.0);
+        present[ch] = 0;
+        sum[ch] = sum_sq[ch] = 0.0;
+        min_queue[ch].items.assign(window, 0);
+        min_queue[ch].head = min_queue[ch].count = 0;
+        max_queue[ch].items.assign(window, 0);
+        max_queue[ch].head = max_queue[ch].count = 0;
+    }
+    for (int i = 0; i < RESULT_WORDS; ++i) result[i].store(0, std::memory_order_relaxed);
+}
+
+void WindowAggregate::expire(MonotonicQueue& queue, uint64_t index) {
+    // Mỗi mẫu chỉ đẩy tối đa một chỉ số ra khỏi cửa sổ
+    if (queue.count > 0 && queue.items[queue.head] + window_size <= index) {
+        queue.head = (queue.head + 1) % queue.items.size();
+        --queue.count;
+    }
+}
+
+void WindowAggregate::push(MonotonicQueue& queue, const std::vector<double>& ring, uint64_t index, bool keep_max) {
+    size_t capacity = queue.items.size();
+
+    // Bỏ các phần tử cuối không thể là cực trị nữa
+    double value = ring[index % window_size];
+    while (queue.count > 0) {
+        size_t tail = (queue.head + queue.count - 1) % capacity;
+        double other = ring[queue.items[tail] % window_size];
+        if (keep_max ? other > value : other < value) break;
+        --queue.count;
+    }
+
+    queue.items[(queue.head + queue.count) % capacity] = index;
+    ++queue.count;
+}
+
+void WindowAggregate::resum(int ch) {
+    // Tính lại tổng từ vòng đệm để sai số cộng/trừ dồn không tích lũy mãi
+    size_t n = total < window_size ? (size_t)total : window_size;
+    double s = 0.0, sq = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (!(masks[i] & channelBit(ch))) continue;
+        s += values[ch][i];
+        sq += values[ch][i] * values[ch][i];
+    }
+    sum[ch] = s;
+    sum_sq[ch] = sq;
+}
+
+bool WindowAggregate::add(const SampleFrame& frame) {
+    uint64_t i = total++;
+    size_t slot = i % window_size;
+    ChannelMask old_mask = i >= window_size ? masks[slot] : 0;
+    ChannelMask mask = frame.channel_mask & CHANNEL_MASK_ALL;
+    masks[slot] = mask;
+
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        ChannelMask bit = channelBit(ch);
+        if (old_mask & bit) {
+            double old = values[ch][slot];
+            sum[ch] -= old;
+            sum_sq[ch] -= old * old;
+            --present[ch];
+        }
+        expire(min_queue[ch], i);
+        expire(max_queue[ch], i);
+        if (mask & bit) {
+            double value = frame.values[ch];
+            values[ch][slot] = value;
+            sum[ch] += value;
+            sum_sq[ch] += value * value;
+            ++present[ch];
+            push(min_queue[ch], values[ch], i, false);
+            push(max_queue[ch], values[ch], i, true);
+        }
+
+        if (slot == window_size - 1) resum(ch);
+    }
+
+    if (total % stride_size != 0) return false;
+
+    AggregateFrame out;
+    out.channel_mask = 0;
+    out.sequence = next_sequence++;
+    out.timestamp_us = frame.timestamp_us;
+    out.window = (uint16_t)window_size;
+    out.stride = (uint16_t)stride_size;
+    out.count = (uint32_t)(total < window_size ? total : window_size);
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        if (present[ch] == 0) {
+            out.mean[ch] = out.min[ch] = out.max[ch] = out.variance[ch] = 0.0;
+            continue;
+        }
+        out.channel_mask |= channelBit(ch);
+        double mean = sum[ch] / present[ch];
+        double variance = sum_sq[ch] / present[ch] - mean * mean;
+        out.mean[ch] = mean;
+        out.variance[ch] = variance > 0.0 ? variance : 0.0;
+        out.min[ch] = values[ch][min_queue[ch].items[min_queue[ch].head] % window_size];
+        out.max[ch] = values[ch][max_queue[ch].items[max_queue[ch].head] % window_size];
+    }
+    publish(out);
+    return true;
+}
+
+void WindowAggregate::publish(const AggregateFrame& frame) {
+    uint64_t words[RESULT_WORDS];
+    words[0] = frame.sequence | ((uint64_t)frame.channel_mask << 32);
+    words[1] = frame.timestamp_us;
+    words[2] = frame.count;
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        memcpy(&words[3 + 4 * ch], &frame.mean[ch], sizeof(double));
+        memcpy(&words[4 + 4 * ch], &frame.min[ch], sizeof(double));
+        memcpy(&words[5 + 4 * ch], &frame.max[ch], sizeof(double));
+        memcpy(&words[6 + 4 * ch], &frame.variance[ch], sizeof(double));
+    }
+
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < RESULT_WORDS; ++i) result[i].store(words[i], std::memory_order_relaxed);
+    seq.store(s + 2, std::memory_order_release);
+}
+
+bool WindowAggregate::latest(AggregateFrame& frame) const {
+    uint64_t words[RESULT_WORDS];
+    uint32_t before, after;
+    do {
+        before = seq.load(std::memory_order_acquire);
+        for (int i = 0; i < RESULT_WORDS; ++i) words[i] = result[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = seq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    if (before == 0) return false;
+
+    frame.sequence = (uint32_t)words[0];
+    frame.channel_mask = (ChannelMask)(words[0] >> 32);
+    frame.timestamp_us = words[1];
+    frame.count = (uint32_t)words[2];
+    frame.window = (uint16_t)window_size;
+    frame.stride = (uint16_t)stride_size;
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        memcpy(&frame.mean[ch], &words[3 + 4 * ch], sizeof(double));
+        memcpy(&frame.min[ch], &words[4 + 4 * ch], sizeof(double));
+        memcpy(&frame.max[ch], &words[5 + 4 * ch], sizeof(double));
+        memcpy(&frame.variance[ch], &words[6 + 4 * ch], sizeof(double));
+    }
+    return true;
+}
+
+AggregatorSet::AggregatorSet() : count(0) {
+    pthread_mutex_init(&mutex, NULL);
+    for (int i = 0; i < MAX_AGGREGATES; ++i) {
+        slots[i].aggregate = NULL;
+        slots[i].refs = 0;
+        slots[i].state.store(SLOT_FREE, std::memory_order_relaxed);
+    }
+}
+
+AggregatorSet::~AggregatorSet() {
+    for (int i = 0; i < MAX_AGGREGATES; ++i) delete slots[i].aggregate;
+    pthread_mutex_destroy(&mutex);
+}
+
+WindowAggregate* AggregatorSet::acquire(unsigned window, unsigned stride) {
+    if (window == 0 || window > MAX_WINDOW || stride == 0 || stride > MAX_WINDOW) return NULL;
+
+    pthread_mutex_lock(&mutex);
+    int n = count.load(std::memory_order_relaxed);
+    WindowAggregate* found = NULL;
+    int free_slot = -1;
+    for (int i = 0; i < n && !found; ++i) {
+        Slot& slot = slots[i];
+        int state = slot.state.load(std::memory_order_acquire);
+        if (state != SLOT_FREE && slot.aggregate->window() == window && slot.aggregate->stride() == stride) {
+            // Slot vừa trả nhưng thread lấy mẫu chưa bỏ: lấy lại, giữ nguyên cửa sổ đang tính
+            if (state == SLOT_ACTIVE ||
+                slot.state.compare_exchange_strong(state, SLOT_ACTIVE, std::memory_order_acq_rel)) {
+                ++slot.refs;
+                found = slot.aggregate;
+                break;
+            }
+            state = SLOT_FREE;
+        }
+        if (state == SLOT_FREE && free_slot < 0) free_slot = i;
+    }
+    if (!found && free_slot < 0 && n < MAX_AGGREGATES) free_slot = n;
+    if (!found && free_slot >= 0) {
+        // Slot FREE không còn được thread lấy mẫu đọc: khởi tạo xong rồi mới công bố ACTIVE
+        // (và count) để thread lấy mẫu không thấy đối tượng dở dang
+        Slot& slot = slots[free_slot];
+        if (slot.aggregate) slot.aggregate->reset(window, stride);
+        else slot.aggregate = new WindowAggregate(free_slot, window, stride);
+        slot.refs = 1;
+        slot.state.store(SLOT_ACTIVE, std::memory_order_release);
+        if (free_slot == n) count.store(n + 1, std::memory_order_release);
+        found = slot.aggregate;
+    }
+    pthread_mutex_unlock(&mutex);
+    return found;
+}
+
+void AggregatorSet::release(WindowAggregate* aggregate) {
+    pthread_mutex_lock(&mutex);
+    Slot& slot = slots[aggregate->id()];
+    if (--slot.refs == 0) slot.state.store(SLOT_RELEASED, std::memory_order_release);
+    pthread_mutex_unlock(&mutex);
+}
+
+void AggregatorSet::notifyOnResult(int event_fd) {
+    notify_fds.push_back(event_fd);
+}
+
+int AggregatorSet::active() const {
+    int n = count.load(std::memory_order_acquire);
+    int result = 0;
+    for (int i = 0; i < n; ++i) {
+        if (slots[i].state.load(std::memory_order_relaxed) == SLOT_ACTIVE) ++result;
+    }
+    return result;
+}
+
+void AggregatorSet::onSample(const SampleFrame& frame) {
+    int n = count.load(std::memory_order_acquire);
+    bool published = false;
+    for (int i = 0; i < n; ++i) {
+        Slot& slot = slots[i];
+        int state = slot.state.load(std::memory_order_acquire);
+        if (state == SLOT_ACTIVE) {
+            if (slot.aggregate->add(frame)) published = true;
+        } else if (state == SLOT_RELEASED) {
+            // Không còn subscriber: ngừng tính và trả slot. CAS thất bại nghĩa là vừa có
+            // subscriber lấy lại, slot được tính tiếp từ mẫu sau
+            slot.state.compare_exchange_strong(state, SLOT_FREE, std::memory_order_acq_rel);
+        }
+    }
+    if (!published) return;
+    // eventfd cộng dồn: reactor chưa kịp đọc thì chỉ thấy một lần đánh thức
+    uint64_t one = 1;
+    for (size_t i = 0; i < notify_fds.size(); ++i) {
+        ssize_t ignored = write(notify_fds[i], &one, sizeof(one));
+        (void)ignored;
+    }
+}
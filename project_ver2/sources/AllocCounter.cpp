@@ -0,0 +1,22 @@
+#include "AllocCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+static thread_local uint64_t thread_allocations = 0;
+
+uint64_t threadAllocations() {
+    return thread_allocations;
+}
+
+// libstdc++ chuyển new[] và bản nothrow về operator new(size_t), nên chỉ cần thay hàm này
+void* operator new(std::size_t size) {
+    ++thread_allocations;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
@@ -1,15 +1,47 @@
 #include "Client.h"
 
-Client::Client(const std::string& ip, int port, LogLevel level)
-    : server_ip(ip), server_port(port), log_level(level), sock(-1), running(false) {}
+Client::Client(const std::string& ip, int port, LogLevel level, int stream_rate_hz)
+    : sock(-1), multicast(NULL), shm(NULL), data_thread_active(false), running(false) {
+    config.server_ip = ip;
+    config.server_port = port;
+    config.log_level = level;
+    config.stream_rate_hz = stream_rate_hz;
+    Logger::instance().setLevel(level);
+}
+
+Client::Client(const ClientConfig& config)
+    : sock(-1), config(config), multicast(NULL), shm(NULL), data_thread_active(false), running(false) {
+    Logger::instance().setLevel(config.log_level);
+}
 
 Client::~Client() {
     stop();
+    delete multicast;
+    delete shm;
 }
 
 bool Client::connectToServer() {
     struct sockaddr_in serv_addr;
 
+    if (!config.shm_name.empty()) {
+        // Cùng máy với server: đọc thẳng vòng đệm trong /dev/shm
+        shm = new ShmRingReader(config.shm_name);
+        if (!shm->open()) return false;
+        LOG_INFO("Reading samples from shared memory ring %s", config.shm_name.c_str());
+        return true;
+    }
+
+    if (!config.multicast_group.empty()) {
+        // Chế độ multicast: không có kết nối TCP, chỉ tham gia nhóm
+        multicast = new MulticastReceiver(config.multicast_group, config.multicast_port,
+                                          config.multicast_interface);
+        if (!multicast->open()) return false;
+        LOG_INFO("Joined multicast group %s:%d", config.multicast_group.c_str(), config.multicast_port);
+        return true;
+    }
+
+    if (!config.unix_path.empty()) return connectUnix();
+
     if ((sock = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
         perror("Socket creation failed");
         return false;
@@ -18,9 +50,9 @@ bool Client::connectToServer() {
     fcntl(sock, F_SETFL, O_NONBLOCK);
 
     serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(server_port);
+    serv_addr.sin_port = htons(config.server_port);
 
-    if (inet_pton(AF_INET, server_ip.c_str(), &serv_addr.sin_addr) <= 0) {
+    if (inet_pton(AF_INET, config.server_ip.c_str(), &serv_addr.sin_addr) <= 0) {
         perror("Invalid address");
         close(sock);
         return false;
@@ -59,20 +91,89 @@ bool Client::connectToServer() {
         close(epoll_fd);
     }
 
-    std::cout << "Connected to Z-turn Server at " << server_ip << ":" << server_port << std::endl;
+    LOG_INFO("Connected to Z-turn Server at %s:%d", config.server_ip.c_str(), config.server_port);
+    return true;
+}
+
+bool Client::connectUnix() {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (config.unix_path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Unix socket path too long: " << config.unix_path << std::endl;
+        return false;
+    }
+    strcpy(address.sun_path, config.unix_path.c_str());
+
+    if ((sock = socket(AF_UNIX, config.unix_seqpacket ? SOCK_SEQPACKET : SOCK_STREAM, 0)) < 0) {
+        perror("Socket creation failed");
+        return false;
+    }
+
+    // connect AF_UNIX hoàn tất ngay (không có handshake), chuyển non-blocking sau đó
+    if (connect(sock, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        perror("Connection failed");
+        close(sock);
+        sock = -1;
+        return false;
+    }
+    fcntl(sock, F_SETFL, O_NONBLOCK);
+
+    LOG_INFO("Connected to Z-turn Server at %s", config.unix_path.c_str());
     return true;
 }
 
 void Client::start() {
     running = true;
-    if (pthread_create(&data_thread, NULL, processDataThread, this) < 0) {
+    if (config.realtime.lock_memory) lockMemory(256 * 1024, 4 * 1024 * 1024, 512 * 1024);
+    if (pthread_create(&data_thread, NULL, processDataThread, this) != 0) {
         perror("Thread creation failed");
         close(sock);
         return;
     }
+    data_thread_active = true;
+
+    if (multicast || shm) {
+        pthread_join(data_thread, NULL);
+        data_thread_active = false;
+        return;
+    }
+
+    if (config.binary || config.gorilla) {
+        // Frame nhị phân tự nhận diện bằng magic nên không cần chờ "OK"
+        std::string request = config.gorilla ? "PROTOCOL GORILLA\n" : "PROTOCOL BINARY\n";
+        if (send(sock, request.c_str(), request.length(), MSG_NOSIGNAL) < 0) {
+            perror("Send failed");
+        }
+    }
+
+    if (!config.policy.empty()) {
+        // Chính sách của server khi client này không đọc kịp (DROP_OLDEST, COALESCE, DISCONNECT)
+        std::string request = "POLICY " + config.policy + "\n";
+        if (send(sock, request.c_str(), request.length(), MSG_NOSIGNAL) < 0) {
+            perror("Send failed");
+        }
+    }
+
+    if (config.stream_rate_hz > 0 || config.aggregate_window > 0) {
+        // Streaming: chỉ gửi SUBSCRIBE (hoặc AGGREGATE) một lần, sau đó chờ thread nhận dữ liệu kết thúc
+        std::string request = "SUBSCRIBE " + std::to_string(config.stream_rate_hz) + "\n";
+        if (config.aggregate_window > 0) {
+            request = "AGGREGATE " + std::to_string(config.aggregate_window) + " " +
+                      std::to_string(config.aggregate_stride) + "\n";
+        }
+        if (send(sock, request.c_str(), request.length(), MSG_NOSIGNAL) < 0) {
+            perror("Send failed");
+            running = false;
+        }
+        pthread_join(data_thread, NULL);
+        data_thread_active = false;
+        return;
+    }
 
     const auto frequency = 600;
     const auto period = std::chrono::microseconds(static_cast<long>(1000000.0 / frequency));
+    applyThreadProfile("pacing", config.realtime.timing_cpu, config.realtime.timing_priority);
     auto next_time = std::chrono::high_resolution_clock::now();
     std::string request = "GET_DATA\n";
 
@@ -90,16 +191,41 @@ void Client::start() {
         auto now = std::chrono::high_resolution_clock::now();
         if (now < next_time) {
             std::this_thread::sleep_until(next_time);
+            int64_t late_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::high_resolution_clock::now() - next_time).count();
+            pacing_jitter.record(late_ns > 0 ? late_ns : 0);
         } else {
-            std::cout << "Warning: Cannot keep up with 300 Hz frequency" << std::endl;
+            LOG_EVERY_MS(INFO, 1000, "Warning: Cannot keep up with %d Hz frequency", frequency);
         }
+        LOG_EVERY_MS(INFO, 1000, "Pacing jitter: %s", formatJitter().c_str());
     }
+    LOG_INFO("Pacing jitter over the run: %s", formatJitter().c_str());
+}
+
+std::string Client::formatJitter() const {
+    LatencySnapshot snapshot;
+    snapshot.add(pacing_jitter);
+    char text[160];
+    snapshot.format(text, sizeof(text));
+    return text;
 }
 
 void Client::stop() {
     running = false;
+    if ((multicast || shm) && data_thread_active) {
+        pthread_join(data_thread, NULL);
+        data_thread_active = false;
+    }
     if (sock >= 0) {
-        pthread_cancel(data_thread);
+        if (config.stream_rate_hz > 0 || config.aggregate_window > 0) {
+            std::string request = "UNSUBSCRIBE\n";
+            send(sock, request.c_str(), request.length(), MSG_NOSIGNAL);
+        }
+        if (data_thread_active) {
+            pthread_cancel(data_thread);
+            pthread_join(data_thread, NULL);
+            data_thread_active = false;
+        }
         close(sock);
         sock = -1;
     }
@@ -107,14 +233,26 @@ void Client::stop() {
 
 void* Client::processDataThread(void* arg) {
     Client* client = static_cast<Client*>(arg);
+    applyThreadProfile("receive", client->config.realtime.networkCpu(0), client->config.realtime.network_priority);
     client->processData();
     return NULL;
 }
 
 void Client::processData() {
+    if (multicast) {
+        receiveMulticast();
+        return;
+    }
+    if (shm) {
+        receiveShm();
+        return;
+    }
+
     std::string accumulated_data;
-    char buffer[2048] = {0};
-    DataLists data;
+    // Đủ lớn cho một message SOCK_SEQPACKET (read cắt bỏ phần vượt quá buffer)
+    static const int READ_BUFFER_SIZE = 65536;
+    std::vector<char> buffer(READ_BUFFER_SIZE);
+    SampleWindow data;
 
     while (running) {
         int epoll_fd = epoll_create1(0);
@@ -139,75 +277,178 @@ void Client::processData() {
             continue;
         }
 
-        int valread = read(sock, buffer, 2048);
+        int valread = read(sock, buffer.data(), READ_BUFFER_SIZE);
+        if (valread == 0) {
+            // Server đóng kết nối
+            LOG_INFO("Server closed the connection");
+            running = false;
+        }
         if (valread > 0) {
-            buffer[valread] = '\0';
-            accumulated_data += std::string(buffer);
+            accumulated_data.append(buffer.data(), valread);
 
             size_t pos = 0;
-            while ((pos = accumulated_data.find('\n')) != std::string::npos) {
-                std::string line = accumulated_data.substr(0, pos);
-                accumulated_data.erase(0, pos + 1);
-
-                double value;
-                if (line.find("AZ:") == 0) {
-                    value = std::stod(line.substr(3));
-                    data.azimuth_list.push_back(value);
-                    data.azimuth_sum += value;
-                    if (log_level == DEBUG) std::cout << "Received AZ: " << value << std::endl;
-                    if (data.azimuth_list.size() > data.SAMPLE_SIZE) {
-                        data.azimuth_sum -= data.azimuth_list.front();
-                        data.azimuth_list.pop_front();
-                    }
-                    if (data.azimuth_list.size() == data.SAMPLE_SIZE && log_level == INFO) {
-                        std::cout << "Azimuth average (50 samples): "
-                                  << data.azimuth_sum / data.SAMPLE_SIZE << std::endl;
+            while (pos < accumulated_data.size()) {
+                if ((unsigned char)accumulated_data[pos] == FRAME_MAGIC_BYTE0 &&
+                    isGorillaBlock(accumulated_data.data() + pos, accumulated_data.size() - pos)) {
+                    SampleFrame frames[GORILLA_MAX_BLOCK_SAMPLES];
+                    unsigned count;
+                    int used = decodeGorillaBlock(accumulated_data.data() + pos,
+                                                  accumulated_data.size() - pos, frames, count);
+                    if (used == 0) break;
+                    if (used < 0) {
+                        ++pos;
+                        continue;
                     }
+                    for (unsigned i = 0; i < count; ++i) data.add(frames[i]);
+                    pos += used;
+                    continue;
                 }
-                else if (line.find("EL:") == 0) {
-                    value = std::stod(line.substr(3));
-                    data.elevation_list.push_back(value);
-                    data.elevation_sum += value;
-                    if (log_level == DEBUG) std::cout << "Received EL: " << value << std::endl;
-                    if (data.elevation_list.size() > data.SAMPLE_SIZE) {
-                        data.elevation_sum -= data.elevation_list.front();
-                        data.elevation_list.pop_front();
-                    }
-                    if (data.elevation_list.size() == data.SAMPLE_SIZE && log_level == INFO) {
-                        std::cout << "Elevation average (50 samples): "
-                                  << data.elevation_sum / data.SAMPLE_SIZE << std::endl;
-                    }
-                }
-                else if (line.find("TE:") == 0) {
-                    value = std::stod(line.substr(3));
-                    data.temperature_list.push_back(value);
-                    data.temperature_sum += value;
-                    if (log_level == DEBUG) std::cout << "Received TE: " << value << std::endl;
-                    if (data.temperature_list.size() > data.SAMPLE_SIZE) {
-                        data.temperature_sum -= data.temperature_list.front();
-                        data.temperature_list.pop_front();
-                    }
-                    if (data.temperature_list.size() == data.SAMPLE_SIZE && log_level == INFO) {
-                        std::cout << "Temperature average (50 samples): "
-                                  << data.temperature_sum / data.SAMPLE_SIZE << std::endl;
+                if ((unsigned char)accumulated_data[pos] == FRAME_MAGIC_BYTE0 &&
+                    isAggregateFrame(accumulated_data.data() + pos, accumulated_data.size() - pos)) {
+                    AggregateFrame aggregate;
+                    int used = decodeAggregateFrame(accumulated_data.data() + pos,
+                                                    accumulated_data.size() - pos, aggregate);
+                    if (used == 0) break;
+                    if (used < 0) {
+                        ++pos;
+                        continue;
                     }
+                    char text[TEXT_AGGREGATE_MAX_SIZE];
+                    logAggregate(text, encodeTextAggregate(aggregate, text));
+                    pos += used;
+                    continue;
                 }
-                else if (line.find("HU:") == 0) {
-                    value = std::stod(line.substr(3));
-                    data.humidity_list.push_back(value);
-                    data.humidity_sum += value;
-                    if (log_level == DEBUG) std::cout << "Received HU: " << value << std::endl;
-                    if (data.humidity_list.size() > data.SAMPLE_SIZE) {
-                        data.humidity_sum -= data.humidity_list.front();
-                        data.humidity_list.pop_front();
-                    }
-                    if (data.humidity_list.size() == data.SAMPLE_SIZE && log_level == INFO) {
-                        std::cout << "Humidity average (50 samples): "
-                                  << data.humidity_sum / data.SAMPLE_SIZE << std::endl;
+                if ((unsigned char)accumulated_data[pos] == FRAME_MAGIC_BYTE0) {
+                    SampleFrame frame;
+                    int used = decodeFrame(accumulated_data.data() + pos,
+                                           accumulated_data.size() - pos, frame);
+                    if (used == 0) break;       // frame chưa nhận đủ
+                    if (used < 0) {
+                        // Dữ liệu hỏng: bỏ qua byte này để đồng bộ lại
+                        ++pos;
+                        continue;
                     }
+                    data.add(frame);
+                    pos += used;
+                    continue;
                 }
+
+                size_t end = accumulated_data.find('\n', pos);
+                if (end == std::string::npos) break;
+                std::string line = accumulated_data.substr(pos, end - pos);
+                pos = end + 1;
+
+                // "<tag>:<value>": tra kênh theo tag trong O(1), không so từng tiền tố
+                int channel = line.size() > 3 && line[2] == ':' ? channelFromTag(line[0], line[1]) : -1;
+                if (channel >= 0) data.add(channel, strtod(line.c_str() + 3, NULL));
+                else if (line.compare(0, 4, "AGG ") == 0) logAggregate(line.data(), line.size());
+            }
+            accumulated_data.erase(0, pos);
+
+            // INFO: một dòng tóm tắt mỗi giây thay vì một dòng cho mỗi mẫu
+            if (data.full()) {
+                char averages[CH_COUNT * 24];
+                data.formatAverages(averages, sizeof(averages));
+                LOG_EVERY_MS(INFO, 1000, "Average (%d samples): %s", data.SAMPLE_SIZE, averages);
             }
         }
         close(epoll_fd);
     }
 }
+
+void SampleWindow::add(int channel, double value) {
+    double& slot = values[added[channel] % SAMPLE_SIZE][channel];
+    // Vòng đệm đã đầy: giá trị bị ghi đè ra khỏi cửa sổ
+    if (added[channel] >= (uint64_t)SAMPLE_SIZE) sums[channel] -= slot;
+    slot = value;
+    sums[channel] += value;
+    ++added[channel];
+    LOG_DEBUG("Received %s: %f", CHANNELS[channel].tag, value);
+}
+
+void SampleWindow::add(const SampleFrame& frame) {
+    for (ChannelMask mask = frame.channel_mask & CHANNEL_MASK_ALL; mask; mask &= mask - 1) {
+        int ch = __builtin_ctz(mask);
+        add(ch, frame.values[ch]);
+    }
+}
+
+void SampleWindow::formatAverages(char* out, size_t size) const {
+    size_t used = 0;
+    out[0] = '\0';
+    for (int ch = 0; ch < CH_COUNT && used < size; ++ch) {
+        int n = snprintf(out + used, size - used, "%s%s=%f", ch ? " " : "", CHANNELS[ch].tag,
+                         sums[ch] / SAMPLE_SIZE);
+        if (n < 0) break;
+        used += n;
+    }
+}
+
+void Client::logAggregate(const char* line, size_t len) {
+    // Kết quả đã ở dạng text "AGG <window>/<stride> n=... AZ:mean,min,max,var ..."
+    if (len > 0 && line[len - 1] == '\n') --len;
+    LOG_DEBUG("Received %.*s", (int)len, line);
+    LOG_EVERY_MS(INFO, 1000, "%.*s", (int)len, line);
+}
+
+void Client::receiveMulticast() {
+    SampleWindow data;
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        return;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = multicast->fd();
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, multicast->fd(), &ev);
+
+    while (running) {
+        struct epoll_event events[1];
+        if (epoll_wait(epoll_fd, events, 1, 50) <= 0) continue;
+
+        SampleFrame frame;
+        int result;
+        while ((result = multicast->receive(frame)) != 0) {
+            if (result < 0) {
+                perror("Multicast receive failed");
+                running = false;
+                break;
+            }
+            data.add(frame);
+        }
+
+        if (data.full()) {
+            char averages[CH_COUNT * 24];
+            data.formatAverages(averages, sizeof(averages));
+            LOG_EVERY_MS(INFO, 1000, "Average (%d samples): %s, %llu received, %llu lost",
+                         data.SAMPLE_SIZE, averages,
+                         (unsigned long long)multicast->received(),
+                         (unsigned long long)multicast->lost());
+        }
+    }
+    close(epoll_fd);
+}
+
+void Client::receiveShm() {
+    SampleWindow data;
+    while (running) {
+        if (!shm->wait(50)) continue;
+
+        SampleFrame frame;
+        while (shm->read(frame)) {
+            data.add(frame);
+        }
+
+        if (data.full()) {
+            char averages[CH_COUNT * 24];
+            data.formatAverages(averages, sizeof(averages));
+            LOG_EVERY_MS(INFO, 1000, "Average (%d samples): %s, %llu received, %llu lost in %llu overrun(s)",
+                         data.SAMPLE_SIZE, averages,
+                         (unsigned long long)shm->received(),
+                         (unsigned long long)shm->lost(),
+                         (unsigned long long)shm->overruns());
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#include "FrameBuffer.h"
+
+void SharedFrame::release() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) pool->recycle(this);
+}
+
+FramePool::~FramePool() {
+    for (size_t i = 0; i < free_frames.size(); ++i) delete free_frames[i];
+}
+
+SharedFrame* FramePool::acquire() {
+    SharedFrame* frame;
+    if (free_frames.empty()) {
+        frame = new SharedFrame();
+        frame->pool = this;
+    } else {
+        frame = free_frames.back();
+        free_frames.pop_back();
+    }
+
+    frame->refs.store(1, std::memory_order_relaxed);
+    return frame;
+}
+
+SharedFrame* FramePool::encode(const SampleFrame& sample, bool binary) {
+    SharedFrame* frame = acquire();
+    frame->sequence = sample.sequence;
+    frame->binary = binary;
+    frame->length = binary ? encodeFrame(sample, frame->data) : encodeTextSample(sample, frame->data);
+    return frame;
+}
+
+SharedFrame* FramePool::encodeAggregate(const AggregateFrame& aggregate, bool binary) {
+    SharedFrame* frame = acquire();
+    frame->sequence = aggregate.sequence;
+    frame->binary = binary;
+    frame->length = binary ? encodeAggregateFrame(aggregate, frame->data) : encodeTextAggregate(aggregate, frame->data);
+    return frame;
+}
+
+void FramePool::recycle(SharedFrame* frame) {
+    free_frames.push_back(frame);
+}
@@ -0,0 +1,274 @@
+#include "Gorilla.h"
+
+#include <cstring>
+
+namespace {
+
+// Header little-endian như frame mẫu (Protocol.cpp); riêng bit stream ghi MSB trước
+inline void putU16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+inline void putU32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+inline void putU64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+inline uint16_t getU16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t getU32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+inline uint64_t getU64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+inline uint32_t floatBits(double value) {
+    float f = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+inline double bitsFloat(uint32_t bits) {
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Số nguyên có dấu bits bit (bù 2) -> int64_t
+inline int64_t signExtend(uint64_t value, int bits) {
+    uint64_t sign = 1ULL << (bits - 1);
+    return (int64_t)((value ^ sign) - sign);
+}
+
+const int DOD_BITS[] = { 7, 9, 12 };
+
+class BitReader {
+public:
+    BitReader(const unsigned char* data, size_t len) : pos(data), end(data + len), acc(0), acc_bits(0), failed(false) {}
+
+    uint64_t read(int bits) {
+        while (acc_bits < bits) {
+            if (pos == end) {
+                failed = true;
+                return 0;
+            }
+            acc = (acc << 8) | *pos++;
+            acc_bits += 8;
+        }
+        acc_bits -= bits;
+        return (acc >> acc_bits) & ((1ULL << bits) - 1);
+    }
+
+    bool ok() const { return !failed; }
+
+private:
+    const unsigned char* pos;
+    const unsigned char* end;
+    uint64_t acc;
+    int acc_bits;
+    bool failed;
+};
+
+int64_t readDod(BitReader& reader) {
+    // Số bit 1 đứng đầu chọn độ dài: 0, 7, 9, 12 hoặc 32 bit
+    int prefix = 0;
+    while (prefix < 4 && reader.read(1)) ++prefix;
+    if (prefix == 0) return 0;
+    int bits = prefix < 4 ? DOD_BITS[prefix - 1] : 32;
+    return signExtend(reader.read(bits), bits);
+}
+
+} // namespace
+
+void GorillaEncoder::begin(char* buffer) {
+    out = (unsigned char*)buffer;
+    pos = out + GORILLA_HEADER_SIZE;
+    acc = 0;
+    acc_bits = 0;
+    samples = 0;
+}
+
+void GorillaEncoder::writeBits(uint64_t value, int bits) {
+    // bits <= 32: acc giữ tối đa 7 + 32 bit
+    acc = (acc << bits) | (value & ((1ULL << bits) - 1));
+    acc_bits += bits;
+    while (acc_bits >= 8) {
+        acc_bits -= 8;
+        *pos++ = (unsigned char)(acc >> acc_bits);
+    }
+}
+
+void GorillaEncoder::writeDod(int64_t dod) {
+    if (dod == 0) {
+        writeBits(0, 1);
+        return;
+    }
+    for (int i = 0; i < 3; ++i) {
+        int64_t limit = 1LL << (DOD_BITS[i] - 1);
+        if (dod >= -limit && dod < limit) {
+            writeBits(((1u << (i + 1)) - 1) << 1, i + 2);     // 10, 110, 1110
+            writeBits((uint64_t)dod, DOD_BITS[i]);
+            return;
+        }
+    }
+    writeBits(0xF, 4);
+    writeBits((uint64_t)dod, 32);
+}
+
+void GorillaEncoder::writeXor(int ch, uint32_t bits) {
+    uint32_t x = bits ^ prev_values[ch];
+    prev_values[ch] = bits;
+    if (x == 0) {
+        writeBits(0, 1);
+        return;
+    }
+
+    int leading = __builtin_clz(x);
+    int trailing = __builtin_ctz(x);
+    if (prev_leading[ch] >= 0 && leading >= prev_leading[ch] && trailing >= prev_trailing[ch]) {
+        // Bit có nghĩa nằm trong cửa sổ của giá trị trước: không cần ghi lại vị trí
+        writeBits(0x2, 2);
+        writeBits(x >> prev_trailing[ch], 32 - prev_leading[ch] - prev_trailing[ch]);
+        return;
+    }
+
+    int length = 32 - leading - trailing;
+    writeBits(0x3, 2);
+    writeBits(leading, 5);
+    writeBits(length - 1, 5);
+    writeBits(x >> trailing, length);
+    prev_leading[ch] = leading;
+    prev_trailing[ch] = trailing;
+}
+
+bool GorillaEncoder::add(const SampleFrame& frame) {
+    if (samples == 0) {
+        mask = frame.channel_mask;
+        prev_sequence = frame.sequence;
+        prev_time_us = frame.timestamp_us;
+        prev_sequence_delta = 0;
+        prev_time_delta = 0;
+        putU32(out + 4, frame.sequence);
+        putU64(out + 8, frame.timestamp_us);
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            prev_leading[ch] = -1;
+            prev_trailing[ch] = 0;
+            prev_values[ch] = floatBits(frame.values[ch]);
+            if (mask & channelBit(ch)) writeBits(prev_values[ch], 32);
+        }
+        ++samples;
+        return true;
+    }
+
+    if (samples == GORILLA_MAX_BLOCK_SAMPLES || frame.channel_mask != mask) return false;
+
+    // Khoảng cách quá lớn (đồng hồ nhảy) không vừa 32 bit: để khối mới bắt đầu lại
+    int64_t sequence_delta = (int64_t)frame.sequence - (int64_t)prev_sequence;
+    int64_t time_delta = (int64_t)(frame.timestamp_us - prev_time_us);
+    int64_t sequence_dod = sequence_delta - prev_sequence_delta;
+    int64_t time_dod = time_delta - prev_time_delta;
+    if (sequence_dod < INT32_MIN || sequence_dod > INT32_MAX || time_dod < INT32_MIN || time_dod > INT32_MAX) {
+        return false;
+    }
+
+    writeDod(sequence_dod);
+    writeDod(time_dod);
+    prev_sequence = frame.sequence;
+    prev_time_us = frame.timestamp_us;
+    prev_sequence_delta = sequence_delta;
+    prev_time_delta = time_delta;
+
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        if (mask & channelBit(ch)) writeXor(ch, floatBits(frame.values[ch]));
+    }
+    ++samples;
+    return true;
+}
+
+size_t GorillaEncoder::finish() {
+    if (acc_bits > 0) {
+        *pos++ = (unsigned char)(acc << (8 - acc_bits));
+        acc_bits = 0;
+    }
+
+    putU16(out, FRAME_MAGIC);
+    out[2] = FRAME_VERSION;
+    out[3] = FRAME_FLAG_GORILLA;
+    putChannelMask(out, mask);
+    putU16(out + FRAME_HEADER_SIZE, (uint16_t)samples);
+    putU16(out + FRAME_HEADER_SIZE + 2, (uint16_t)(pos - out - GORILLA_HEADER_SIZE));
+
+    size_t size = pos - out;
+    out = NULL;
+    return size;
+}
+
+int decodeGorillaBlock(const char* data, size_t len, SampleFrame* frames, unsigned& count) {
+    const unsigned char* p = (const unsigned char*)data;
+    if (len < GORILLA_HEADER_SIZE) return 0;
+    ChannelMask mask = getChannelMask(p);
+    count = getU16(p + FRAME_HEADER_SIZE);
+    if (getU16(p) != FRAME_MAGIC || p[2] != FRAME_VERSION || p[3] != FRAME_FLAG_GORILLA ||
+        (mask & ~CHANNEL_MASK_ALL) || count == 0 || count > GORILLA_MAX_BLOCK_SAMPLES) {
+        return -1;
+    }
+
+    size_t size = GORILLA_HEADER_SIZE + getU16(p + FRAME_HEADER_SIZE + 2);
+    if (len < size) return 0;
+
+    BitReader reader(p + GORILLA_HEADER_SIZE, size - GORILLA_HEADER_SIZE);
+    uint32_t values[CH_COUNT] = {0};
+    int leading[CH_COUNT] = {0};
+    int trailing[CH_COUNT] = {0};
+    uint32_t sequence = getU32(p + 4);
+    uint64_t time_us = getU64(p + 8);
+    int64_t sequence_delta = 0;
+    int64_t time_delta = 0;
+
+    for (unsigned i = 0; i < count; ++i) {
+        if (i > 0) {
+            sequence_delta += readDod(reader);
+            time_delta += readDod(reader);
+            sequence += (uint32_t)sequence_delta;
+            time_us += (uint64_t)time_delta;
+        }
+
+        SampleFrame& frame = frames[i];
+        frame.channel_mask = mask;
+        frame.sequence = sequence;
+        frame.timestamp_us = time_us;
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            frame.values[ch] = 0.0;
+            if (!(mask & channelBit(ch))) continue;
+
+            if (i == 0) {
+                values[ch] = (uint32_t)reader.read(32);
+            } else if (reader.read(1)) {
+                if (reader.read(1)) {
+                    leading[ch] = (int)reader.read(5);
+                    int length = (int)reader.read(5) + 1;
+                    trailing[ch] = 32 - leading[ch] - length;
+                    if (trailing[ch] < 0) return -1;
+                }
+                int length = 32 - leading[ch] - trailing[ch];
+                values[ch] ^= (uint32_t)(reader.read(length) << trailing[ch]);
+            }
+            frame.values[ch] = bitsFloat(values[ch]);
+        }
+        if (!reader.ok()) return -1;
+    }
+    return (int)size;
+}
@@ -0,0 +1,97 @@
+#include "History.h"
+
+#include <cstring>
+
+SampleHistory::SampleHistory(size_t budget_bytes) : head(0), reserved(0) {
+    size_t samples = budget_bytes / BYTES_PER_SAMPLE;
+    size_t capacity = 1;
+    while (capacity * 2 <= samples) capacity *= 2;
+    mask = capacity - 1;
+
+    timestamps.reset(new std::atomic<uint64_t>[capacity]());
+    sequences.reset(new std::atomic<uint32_t>[capacity]());
+    masks.reset(new std::atomic<ChannelMask>[capacity]());
+    for (int ch = 0; ch < CH_COUNT; ++ch) values[ch].reset(new std::atomic<uint32_t>[capacity]());
+}
+
+void SampleHistory::onSample(const SampleFrame& frame) {
+    uint64_t index = head.load(std::memory_order_relaxed);
+    uint64_t slot = index & mask;
+
+    // Báo trước slot sắp bị ghi đè để reader đang đọc mẫu cũ ở slot này loại nó ra
+    reserved.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    timestamps[slot].store(frame.timestamp_us, std::memory_order_relaxed);
+    sequences[slot].store(frame.sequence, std::memory_order_relaxed);
+    masks[slot].store(frame.channel_mask, std::memory_order_relaxed);
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        float f = (float)frame.values[ch];
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        values[ch][slot].store(bits, std::memory_order_relaxed);
+    }
+
+    head.store(index + 1, std::memory_order_release);
+}
+
+void SampleHistory::find(uint64_t from_us, uint64_t to_us, uint64_t& first, uint64_t& last) const {
+    uint64_t end = head.load(std::memory_order_acquire);
+    // Chừa một vòng nhỏ ở đầu cũ nhất: các mẫu đó có thể bị ghi đè ngay trong lúc tìm
+    uint64_t margin = capacity() / 16;
+    uint64_t begin = end > capacity() - margin ? end - (capacity() - margin) : 0;
+
+    // lower_bound(from_us) và upper_bound(to_us) trên [begin, end)
+    uint64_t lo = begin, hi = end;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (timestampAt(mid) < from_us) lo = mid + 1;
+        else hi = mid;
+    }
+    first = lo;
+
+    hi = end;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (timestampAt(mid) <= to_us) lo = mid + 1;
+        else hi = mid;
+    }
+    last = lo;
+}
+
+size_t SampleHistory::read(uint64_t& index, SampleFrame* frames, size_t count) const {
+    uint64_t end = head.load(std::memory_order_acquire);
+    if (end > capacity() && index < end - capacity()) index = end - capacity();
+    if (index >= end) return 0;
+    if (count > end - index) count = end - index;
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t slot = (index + i) & mask;
+        SampleFrame& frame = frames[i];
+        frame.timestamp_us = timestamps[slot].load(std::memory_order_relaxed);
+        frame.sequence = sequences[slot].load(std::memory_order_relaxed);
+        frame.channel_mask = masks[slot].load(std::memory_order_relaxed);
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            uint32_t bits = values[ch][slot].load(std::memory_order_relaxed);
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            frame.values[ch] = f;
+        }
+    }
+
+    // Mẫu có chỉ số < reserved - capacity có thể đã bị ghi đè trong lúc copy: bỏ đi
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t written = reserved.load(std::memory_order_relaxed);
+    uint64_t valid_from = written > capacity() ? written - capacity() : 0;
+    if (index < valid_from) {
+        size_t skip = valid_from - index;
+        if (skip >= count) {
+            index = valid_from;
+            return 0;
+        }
+        memmove(frames, frames + skip, (count - skip) * sizeof(SampleFrame));
+        index = valid_from;
+        count -= skip;
+    }
+    return count;
+}
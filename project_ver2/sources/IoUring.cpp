@@ -0,0 +1,176 @@
+#include "IoUring.h"
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params* p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+// Không dùng buf_ring->bufs: trong C++ __DECLARE_FLEX_ARRAY của một số phiên bản
+// header làm lệch offset của bufs (8 thay vì 0) so với layout mà kernel dùng.
+static inline struct io_uring_buf* ringBuf(struct io_uring_buf_ring* ring, unsigned idx) {
+    return reinterpret_cast<struct io_uring_buf*>(ring) + idx;
+}
+
+IoUring::IoUring()
+    : ring_fd(-1), sq_ptr(MAP_FAILED), sq_size(0), cq_ptr(MAP_FAILED), cq_size(0),
+      sqes((struct io_uring_sqe*)MAP_FAILED), sqes_size(0),
+      sq_head(NULL), sq_tail(NULL), sq_mask(NULL), sq_array(NULL), sq_entries(0),
+      sqe_tail(0), sqe_submitted(0), cq_head(NULL), cq_tail(NULL), cq_mask(NULL), cqes(NULL),
+      buf_ring((struct io_uring_buf_ring*)MAP_FAILED), buf_ring_size(0), buf_count(0),
+      buffer_size(0), buffers(NULL) {}
+
+IoUring::~IoUring() {
+    if (buf_ring != MAP_FAILED) munmap(buf_ring, buf_ring_size);
+    free(buffers);
+    if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) munmap(cq_ptr, cq_size);
+    if (sq_ptr != MAP_FAILED) munmap(sq_ptr, sq_size);
+    if (ring_fd >= 0) close(ring_fd);
+}
+
+bool IoUring::kernelAtLeast(int major, int minor) {
+    struct utsname u;
+    int kmajor = 0, kminor = 0;
+    if (uname(&u) != 0 || sscanf(u.release, "%d.%d", &kmajor, &kminor) != 2) return false;
+    return kmajor > major || (kmajor == major && kminor >= minor);
+}
+
+bool IoUring::init(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring_fd = sys_io_uring_setup(entries, &params);
+    if (ring_fd < 0) return false;
+
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        if (cq_size > sq_size) sq_size = cq_size;
+        cq_size = sq_size;
+    }
+
+    sq_ptr = mmap(NULL, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) return false;
+
+    if (single_mmap) {
+        cq_ptr = sq_ptr;
+    } else {
+        cq_ptr = mmap(NULL, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd, IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED) return false;
+    }
+
+    sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = (struct io_uring_sqe*)mmap(NULL, sqes_size, PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+
+    char* sq = (char*)sq_ptr;
+    sq_head = (unsigned*)(sq + params.sq_off.head);
+    sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    sq_array = (unsigned*)(sq + params.sq_off.array);
+    sq_entries = params.sq_entries;
+
+    char* cq = (char*)cq_ptr;
+    cq_head = (unsigned*)(cq + params.cq_off.head);
+    cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    // SQE index i luôn nằm ở slot i: array chỉ cần khởi tạo một lần
+    for (unsigned i = 0; i < sq_entries; ++i) sq_array[i] = i;
+    sqe_tail = sqe_submitted = *sq_tail;
+    return true;
+}
+
+bool IoUring::setupBufferRing(uint16_t group_id, unsigned count, unsigned size) {
+    buf_ring_size = count * sizeof(struct io_uring_buf);
+    buf_ring = (struct io_uring_buf_ring*)mmap(NULL, buf_ring_size, PROT_READ | PROT_WRITE,
+                                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buf_ring == MAP_FAILED) return false;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)buf_ring;
+    reg.ring_entries = count;
+    reg.bgid = group_id;
+    if (sys_io_uring_register(ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return false;
+
+    buf_count = count;
+    buffer_size = size;
+    buffers = (char*)malloc((size_t)count * size);
+    if (!buffers) return false;
+
+    buf_ring->tail = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        struct io_uring_buf* buf = ringBuf(buf_ring, i);
+        buf->addr = (uint64_t)(uintptr_t)buffer((uint16_t)i);
+        buf->len = size;
+        buf->bid = (uint16_t)i;
+    }
+    __atomic_store_n(&buf_ring->tail, (uint16_t)count, __ATOMIC_RELEASE);
+    return true;
+}
+
+void IoUring::recycleBuffer(uint16_t bid) {
+    uint16_t tail = buf_ring->tail;
+    struct io_uring_buf* buf = ringBuf(buf_ring, tail & (buf_count - 1));
+    buf->addr = (uint64_t)(uintptr_t)buffer(bid);
+    buf->len = buffer_size;
+    buf->bid = bid;
+    __atomic_store_n(&buf_ring->tail, (uint16_t)(tail + 1), __ATOMIC_RELEASE);
+}
+
+struct io_uring_sqe* IoUring::getSqe() {
+    unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    if (sqe_tail - head >= sq_entries) return NULL;
+
+    struct io_uring_sqe* sqe = &sqes[sqe_tail & *sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    ++sqe_tail;
+    return sqe;
+}
+
+int IoUring::submit(unsigned wait_nr) {
+    unsigned to_submit = sqe_tail - sqe_submitted;
+    if (to_submit == 0 && wait_nr == 0) return 0;
+
+    __atomic_store_n(sq_tail, sqe_tail, __ATOMIC_RELEASE);
+    sqe_submitted = sqe_tail;
+
+    int ret;
+    do {
+        ret = sys_io_uring_enter(ring_fd, to_submit, wait_nr,
+                                 wait_nr ? IORING_ENTER_GETEVENTS : 0);
+    } while (ret < 0 && errno == EINTR && wait_nr == 0);
+    return ret;
+}
+
+struct io_uring_cqe* IoUring::peekCqe() {
+    unsigned head = *cq_head;
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) return NULL;
+    return &cqes[head & *cq_mask];
+}
+
+void IoUring::cqeSeen() {
+    __atomic_store_n(cq_head, *cq_head + 1, __ATOMIC_RELEASE);
+}
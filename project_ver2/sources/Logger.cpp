@@ -0,0 +1,156 @@
+#include "Logger.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+static const size_t OUTPUT_SIZE = 64 * 1024;
+static const useconds_t IDLE_SLEEP_US = 20000;
+
+static int64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+bool RateLimiter::allow() {
+    int64_t now = monotonicNs();
+    int64_t next = next_ns.load(std::memory_order_relaxed);
+    if (now < next) return false;
+    // Nhiều thread cùng đến hạn: chỉ một thread thắng CAS
+    return next_ns.compare_exchange_strong(next, now + interval_ns, std::memory_order_relaxed);
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : current_level(INFO), rings(NULL), running(true) {
+    output = (char*)malloc(OUTPUT_SIZE);
+    if (pthread_create(&drain_thread, NULL, drainThread, this) != 0) {
+        perror("Logger thread creation failed");
+        running = false;
+    }
+}
+
+Logger::~Logger() {
+    shutdown();
+    Ring* ring = rings.load();
+    while (ring) {
+        Ring* next = ring->next;
+        delete ring;
+        ring = next;
+    }
+    free(output);
+}
+
+void Logger::shutdown() {
+    if (!running.exchange(false)) return;
+    pthread_join(drain_thread, NULL);
+    drain();
+}
+
+Logger::Ring* Logger::threadRing() {
+    // Ring của thread được tạo một lần và giữ đến khi logger bị hủy,
+    // để background thread vẫn đọc được message của thread đã kết thúc
+    static thread_local Ring* ring = NULL;
+    if (!ring) {
+        ring = new Ring();
+        ring->head.store(0);
+        ring->tail.store(0);
+        ring->dropped.store(0);
+        ring->next = rings.load();
+        while (!rings.compare_exchange_weak(ring->next, ring)) {}
+    }
+    return ring;
+}
+
+bool Logger::prepareThread(bool lock) {
+    Ring* ring = threadRing();
+    return !lock || mlock(ring, sizeof(Ring)) == 0;
+}
+
+void Logger::log(LogLevel level, const char* fmt, ...) {
+    if (!enabled(level)) return;
+
+    Ring* ring = threadRing();
+    uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head.load(std::memory_order_acquire) >= RING_SIZE) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record& record = ring->records[tail & (RING_SIZE - 1)];
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    record.time_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(record.text, MESSAGE_SIZE, fmt, args);
+    va_end(args);
+    record.length = n < 0 ? 0 : (n < MESSAGE_SIZE ? n : MESSAGE_SIZE - 1);
+
+    ring->tail.store(tail + 1, std::memory_order_release);
+}
+
+void* Logger::drainThread(void* arg) {
+    Logger* logger = static_cast<Logger*>(arg);
+    while (logger->running.load(std::memory_order_relaxed)) {
+        if (!logger->drain()) usleep(IDLE_SLEEP_US);
+    }
+    return NULL;
+}
+
+bool Logger::drain() {
+    if (!output) return false;
+    size_t used = 0;
+    bool any = false;
+
+    for (Ring* ring = rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+        uint32_t head = ring->head.load(std::memory_order_relaxed);
+        uint32_t tail = ring->tail.load(std::memory_order_acquire);
+
+        for (; head != tail; ++head) {
+            const Record& record = ring->records[head & (RING_SIZE - 1)];
+            // "HH:MM:SS.uuuuuu " + message + '\n'
+            if (used + record.length + 32 > OUTPUT_SIZE) {
+                fwrite(output, 1, used, stdout);
+                used = 0;
+            }
+            time_t seconds = (time_t)(record.time_us / 1000000);
+            struct tm local;
+            localtime_r(&seconds, &local);
+            used += snprintf(output + used, 32, "%02d:%02d:%02d.%06d ", local.tm_hour, local.tm_min,
+                             local.tm_sec, (int)(record.time_us % 1000000));
+            memcpy(output + used, record.text, record.length);
+            used += record.length;
+            output[used++] = '\n';
+            any = true;
+        }
+        ring->head.store(head, std::memory_order_release);
+
+        uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped) {
+            if (used + 64 > OUTPUT_SIZE) {
+                fwrite(output, 1, used, stdout);
+                used = 0;
+            }
+            used += snprintf(output + used, 64, "[logger] dropped %llu messages\n",
+                             (unsigned long long)dropped);
+            any = true;
+        }
+    }
+
+    if (used) {
+        fwrite(output, 1, used, stdout);
+        fflush(stdout);
+    }
+    return any;
+}
@@ -0,0 +1,127 @@
+#include "Multicast.h"
+
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+MulticastPublisher::MulticastPublisher(const std::string& group, int port, int ttl,
+                                       const std::string& interface_ip)
+    : group(group), port(port), ttl(ttl), interface_ip(interface_ip), sock(-1),
+      datagrams_sent(0), send_errors(0) {
+    memset(&dest, 0, sizeof(dest));
+}
+
+MulticastPublisher::~MulticastPublisher() {
+    if (sock >= 0) close(sock);
+}
+
+bool MulticastPublisher::open() {
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    if (inet_pton(AF_INET, group.c_str(), &dest.sin_addr) <= 0 || !IN_MULTICAST(ntohl(dest.sin_addr.s_addr))) {
+        fprintf(stderr, "Invalid multicast group: %s\n", group.c_str());
+        return false;
+    }
+
+    if ((sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        perror("Multicast socket failed");
+        return false;
+    }
+
+    unsigned char ttl_value = (unsigned char)ttl;
+    unsigned char loop = 1;     // consumer trên cùng máy (và loopback) vẫn nhận được
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl_value, sizeof(ttl_value));
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    if (!interface_ip.empty()) {
+        struct in_addr iface;
+        if (inet_pton(AF_INET, interface_ip.c_str(), &iface) <= 0 ||
+            setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) < 0) {
+            perror("IP_MULTICAST_IF failed");
+            return false;
+        }
+    }
+    return true;
+}
+
+void MulticastPublisher::onSample(const SampleFrame& frame) {
+    if (sock < 0) return;
+
+    char encoded[FRAME_MAX_SIZE];
+    size_t length = encodeFrame(frame, encoded);
+    // Non-blocking: socket buffer đầy thì bỏ mẫu này thay vì làm trễ thread lấy mẫu
+    if (sendto(sock, encoded, length, 0, (struct sockaddr*)&dest, sizeof(dest)) < 0) {
+        ++send_errors;
+        return;
+    }
+    ++datagrams_sent;
+}
+
+MulticastReceiver::MulticastReceiver(const std::string& group, int port, const std::string& interface_ip)
+    : group(group), port(port), interface_ip(interface_ip), sock(-1), have_sequence(false),
+      last_sequence(0), frames_received(0), frames_lost(0) {}
+
+MulticastReceiver::~MulticastReceiver() {
+    if (sock >= 0) close(sock);
+}
+
+bool MulticastReceiver::open() {
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    if (inet_pton(AF_INET, group.c_str(), &mreq.imr_multiaddr) <= 0 ||
+        !IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr))) {
+        fprintf(stderr, "Invalid multicast group: %s\n", group.c_str());
+        return false;
+    }
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (!interface_ip.empty() && inet_pton(AF_INET, interface_ip.c_str(), &mreq.imr_interface) <= 0) {
+        fprintf(stderr, "Invalid interface address: %s\n", interface_ip.c_str());
+        return false;
+    }
+
+    if ((sock = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
+        perror("Multicast socket failed");
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // Bind vào địa chỉ nhóm để chỉ nhận datagram của nhóm này trên port đó
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr = mreq.imr_multiaddr;
+    if (bind(sock, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        perror("Multicast bind failed");
+        return false;
+    }
+
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        perror("IP_ADD_MEMBERSHIP failed");
+        return false;
+    }
+    return true;
+}
+
+int MulticastReceiver::receive(SampleFrame& frame) {
+    char buffer[FRAME_MAX_SIZE + 64];
+    ssize_t n = recv(sock, buffer, sizeof(buffer), 0);
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    if (decodeFrame(buffer, n, frame) <= 0) return 0;
+
+    // Sequence tăng đơn điệu; khoảng trống = số datagram đã mất
+    if (have_sequence) {
+        uint32_t gap = frame.sequence - last_sequence;
+        if (gap == 0 || gap > 0x80000000u) return 0;    // trùng hoặc đến muộn
+        frames_lost += gap - 1;
+    }
+    have_sequence = true;
+    last_sequence = frame.sequence;
+    ++frames_received;
+    return 1;
+}
@@ -0,0 +1,310 @@
+#include "Protocol.h"
+
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+// Ghi/đọc từng byte để đúng little-endian bất kể kiến trúc (ARM board, x86 relay)
+static inline void putU16(unsigned char* p, uint16_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static inline void putU32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static inline void putU64(unsigned char* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static inline uint16_t getU16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t getU32(const unsigned char* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static inline uint64_t getU64(const unsigned char* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static inline void putFloat(unsigned char* p, double value) {
+    float f = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    putU32(p, bits);
+}
+
+static inline double getFloat(const unsigned char* p) {
+    uint32_t bits = getU32(p);
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// Codec của từng kênh sinh từ schema: một chuỗi lệnh thẳng putFloat/getFloat với chỉ số
+// hằng; đổi kiểu giá trị trên dây của một kênh chỉ cần sửa bản tương ứng
+typedef unsigned char* (*EncodeValues)(const double*, unsigned char*);
+typedef const unsigned char* (*DecodeValues)(const unsigned char*, double*);
+
+template <int Ch> struct ChannelCodec;
+#define ZTURN_CHANNEL_CODEC(id, tag, name, lo, hi, scale, offset)                  \
+    template <> struct ChannelCodec<id> {                                           \
+        static unsigned char* encode(const double* values, unsigned char* p) {      \
+            putFloat(p, values[id]);                                                \
+            return p + sizeof(float);                                               \
+        }                                                                           \
+        static const unsigned char* decode(const unsigned char* p, double* values) { \
+            values[id] = getFloat(p);                                               \
+            return p + sizeof(float);                                               \
+        }                                                                           \
+    };
+ZTURN_CHANNELS(ZTURN_CHANNEL_CODEC)
+#undef ZTURN_CHANNEL_CODEC
+
+// Tra theo kênh cho các mask không có codec riêng
+static const EncodeValues CHANNEL_ENCODE[CH_COUNT] = {
+#define ZTURN_CHANNEL_ENCODE(id, tag, name, lo, hi, scale, offset) &ChannelCodec<id>::encode,
+    ZTURN_CHANNELS(ZTURN_CHANNEL_ENCODE)
+#undef ZTURN_CHANNEL_ENCODE
+};
+
+static const DecodeValues CHANNEL_DECODE[CH_COUNT] = {
+#define ZTURN_CHANNEL_DECODE(id, tag, name, lo, hi, scale, offset) &ChannelCodec<id>::decode,
+    ZTURN_CHANNELS(ZTURN_CHANNEL_DECODE)
+#undef ZTURN_CHANNEL_DECODE
+};
+
+// Codec sinh riêng cho một mask lúc biên dịch: điều kiện "kênh có trong mask" là hằng số
+// nên mỗi bản chỉ còn chuỗi codec kênh liên tiếp, không rẽ nhánh.
+template <unsigned Mask, int Ch = 0, bool Done = (Ch == CH_COUNT || ((uint64_t)Mask >> (Ch)) == 0)>
+struct MaskCodec {
+    static unsigned char* encode(const double* values, unsigned char* p) {
+        if (Mask & (1u << Ch)) p = ChannelCodec<Ch>::encode(values, p);
+        return MaskCodec<Mask, (Ch + 1)>::encode(values, p);
+    }
+
+    static const unsigned char* decode(const unsigned char* p, double* values) {
+        if (Mask & (1u << Ch)) p = ChannelCodec<Ch>::decode(p, values);
+        return MaskCodec<Mask, (Ch + 1)>::decode(p, values);
+    }
+};
+
+template <unsigned Mask, int Ch>
+struct MaskCodec<Mask, Ch, true> {
+    static unsigned char* encode(const double*, unsigned char* p) { return p; }
+    static const unsigned char* decode(const unsigned char* p, double*) { return p; }
+};
+
+// Bảng codec chỉ cho các mask thường gặp: mọi tập con của COMMON_CHANNELS kênh đầu
+// (bộ kênh góc/môi trường gốc, GET_RANGE chọn kênh trong số đó). Kích thước bảng
+// không tăng theo CH_COUNT; các mask khác đi vòng lặp qua các bit được bật.
+const int COMMON_CHANNELS = CH_COUNT < 4 ? CH_COUNT : 4;
+const ChannelMask COMMON_MASKS = (ChannelMask)1 << COMMON_CHANNELS;
+
+template <unsigned... Masks> struct MaskList {};
+template <unsigned N, unsigned... Masks> struct MakeMaskList : MakeMaskList<N - 1, N - 1, Masks...> {};
+template <unsigned... Masks> struct MakeMaskList<0, Masks...> { typedef MaskList<Masks...> type; };
+
+template <class List> struct MaskCodecTable;
+template <unsigned... Masks> struct MaskCodecTable<MaskList<Masks...> > {
+    static const EncodeValues encode[sizeof...(Masks)];
+    static const DecodeValues decode[sizeof...(Masks)];
+};
+template <unsigned... Masks>
+const EncodeValues MaskCodecTable<MaskList<Masks...> >::encode[] = { &MaskCodec<Masks>::encode... };
+template <unsigned... Masks>
+const DecodeValues MaskCodecTable<MaskList<Masks...> >::decode[] = { &MaskCodec<Masks>::decode... };
+
+typedef MaskCodecTable<MakeMaskList<COMMON_MASKS>::type> CommonCodecs;
+
+static inline unsigned char* encodeValues(ChannelMask mask, const double* values, unsigned char* p) {
+    // Mask đầy đủ là trường hợp thường gặp nhất: gọi thẳng bản inline thay vì qua bảng
+    if (mask == CHANNEL_MASK_ALL) return MaskCodec<CHANNEL_MASK_ALL>::encode(values, p);
+    if (mask < COMMON_MASKS) return CommonCodecs::encode[mask](values, p);
+    for (; mask; mask &= mask - 1) p = CHANNEL_ENCODE[__builtin_ctz(mask)](values, p);
+    return p;
+}
+
+static inline void decodeValues(ChannelMask mask, const unsigned char* p, double* values) {
+    if (mask == CHANNEL_MASK_ALL) {
+        MaskCodec<CHANNEL_MASK_ALL>::decode(p, values);
+    } else if (mask < COMMON_MASKS) {
+        CommonCodecs::decode[mask](p, values);
+    } else {
+        for (; mask; mask &= mask - 1) p = CHANNEL_DECODE[__builtin_ctz(mask)](p, values);
+    }
+}
+
+size_t encodeFrame(const SampleFrame& frame, char* out) {
+    unsigned char* p = (unsigned char*)out;
+    putU16(p, FRAME_MAGIC);
+    p[2] = FRAME_VERSION;
+    p[3] = 0;
+    putU32(p + 4, frame.sequence);
+    putU64(p + 8, frame.timestamp_us);
+    putChannelMask(p, frame.channel_mask);
+
+    unsigned char* end = encodeValues(frame.channel_mask & CHANNEL_MASK_ALL, frame.values, p + FRAME_HEADER_SIZE);
+    return (size_t)(end - p);
+}
+
+int decodeFrame(const char* data, size_t len, SampleFrame& frame) {
+    const unsigned char* p = (const unsigned char*)data;
+    const size_t V1_HEADER_SIZE = 16;
+    if (len < V1_HEADER_SIZE) return 0;
+    if (getU16(p) != FRAME_MAGIC) return -1;
+
+    ChannelMask mask;
+    size_t header;
+    if (p[2] == FRAME_VERSION && p[3] == 0) {
+        if (len < FRAME_HEADER_SIZE) return 0;
+        mask = getChannelMask(p);
+        header = FRAME_HEADER_SIZE;
+    } else if (p[2] == FRAME_VERSION_V1 && !(p[3] & (FRAME_FLAG_AGGREGATE | FRAME_FLAG_GORILLA))) {
+        // Bản ghi cũ: mask u8 ở byte 3
+        mask = p[3];
+        header = V1_HEADER_SIZE;
+    } else {
+        return -1;
+    }
+    if (mask & ~CHANNEL_MASK_ALL) return -1;
+
+    size_t size = header + __builtin_popcount(mask) * sizeof(float);
+    if (len < size) return 0;
+
+    frame.channel_mask = mask;
+    frame.sequence = getU32(p + 4);
+    frame.timestamp_us = getU64(p + 8);
+    decodeValues(mask, p + header, frame.values);
+    return (int)size;
+}
+
+size_t formatFixed(double value, char* out) {
+    // NaN/vô cực hoặc quá lớn cho uint64 sau khi nhân 1e6: để snprintf xử lý
+    if (!(std::fabs(value) < 1e12)) {
+        int n = snprintf(out, FIXED_MAX_SIZE, "%.6e", value);
+        return n < (int)FIXED_MAX_SIZE ? (size_t)n : FIXED_MAX_SIZE - 1;
+    }
+
+    char* p = out;
+    if (std::signbit(value)) {
+        *p++ = '-';
+        value = -value;
+    }
+
+    uint64_t scaled = (uint64_t)(value * 1e6 + 0.5);
+    uint64_t integer = scaled / 1000000;
+    uint32_t fraction = (uint32_t)(scaled % 1000000);
+
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + integer % 10);
+        integer /= 10;
+    } while (integer);
+    while (n) *p++ = digits[--n];
+
+    *p++ = '.';
+    for (int i = 5; i >= 0; --i) {
+        p[i] = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+    return (size_t)(p + 6 - out);
+}
+
+size_t encodeTextSample(const SampleFrame& frame, char* out) {
+    char* p = out;
+    for (ChannelMask mask = frame.channel_mask & CHANNEL_MASK_ALL; mask; mask &= mask - 1) {
+        int ch = __builtin_ctz(mask);
+        memcpy(p, CHANNELS[ch].tag, 2);
+        p[2] = ':';
+        p += 3;
+        p += formatFixed(frame.values[ch], p);
+        *p++ = '\n';
+    }
+    return (size_t)(p - out);
+}
+
+size_t encodeAggregateFrame(const AggregateFrame& frame, char* out) {
+    unsigned char* p = (unsigned char*)out;
+    putU16(p, FRAME_MAGIC);
+    p[2] = FRAME_VERSION;
+    p[3] = FRAME_FLAG_AGGREGATE;
+    putU32(p + 4, frame.sequence);
+    putU64(p + 8, frame.timestamp_us);
+    putChannelMask(p, frame.channel_mask);
+    putU16(p + FRAME_HEADER_SIZE, frame.window);
+    putU16(p + FRAME_HEADER_SIZE + 2, frame.stride);
+    putU32(p + FRAME_HEADER_SIZE + 4, frame.count);
+
+    size_t offset = AGGREGATE_HEADER_SIZE;
+    for (ChannelMask mask = frame.channel_mask & CHANNEL_MASK_ALL; mask; mask &= mask - 1) {
+        int ch = __builtin_ctz(mask);
+        putFloat(p + offset, frame.mean[ch]);
+        putFloat(p + offset + 4, frame.min[ch]);
+        putFloat(p + offset + 8, frame.max[ch]);
+        putFloat(p + offset + 12, frame.variance[ch]);
+        offset += 4 * sizeof(float);
+    }
+    return offset;
+}
+
+int decodeAggregateFrame(const char* data, size_t len, AggregateFrame& frame) {
+    const unsigned char* p = (const unsigned char*)data;
+    if (len < AGGREGATE_HEADER_SIZE) return 0;
+    ChannelMask mask = getChannelMask(p);
+    if (getU16(p) != FRAME_MAGIC || p[2] != FRAME_VERSION || p[3] != FRAME_FLAG_AGGREGATE ||
+        (mask & ~CHANNEL_MASK_ALL)) {
+        return -1;
+    }
+
+    size_t size = AGGREGATE_HEADER_SIZE + (frameSize(mask) - FRAME_HEADER_SIZE) * 4;
+    if (len < size) return 0;
+
+    frame.channel_mask = mask;
+    frame.sequence = getU32(p + 4);
+    frame.timestamp_us = getU64(p + 8);
+    frame.window = getU16(p + FRAME_HEADER_SIZE);
+    frame.stride = getU16(p + FRAME_HEADER_SIZE + 2);
+    frame.count = getU32(p + FRAME_HEADER_SIZE + 4);
+
+    size_t offset = AGGREGATE_HEADER_SIZE;
+    for (ChannelMask bits = mask; bits; bits &= bits - 1) {
+        int ch = __builtin_ctz(bits);
+        frame.mean[ch] = getFloat(p + offset);
+        frame.min[ch] = getFloat(p + offset + 4);
+        frame.max[ch] = getFloat(p + offset + 8);
+        frame.variance[ch] = getFloat(p + offset + 12);
+        offset += 4 * sizeof(float);
+    }
+    return (int)size;
+}
+
+size_t encodeTextAggregate(const AggregateFrame& frame, char* out) {
+    char* p = out;
+    p += snprintf(p, 32, "AGG %u/%u n=%u", (unsigned)frame.window, (unsigned)frame.stride,
+                  (unsigned)frame.count);
+    for (ChannelMask mask = frame.channel_mask & CHANNEL_MASK_ALL; mask; mask &= mask - 1) {
+        int ch = __builtin_ctz(mask);
+        p[0] = ' ';
+        memcpy(p + 1, CHANNELS[ch].tag, 2);
+        p[3] = ':';
+        p += 4;
+        p += formatFixed(frame.mean[ch], p);
+        *p++ = ',';
+        p += formatFixed(frame.min[ch], p);
+        *p++ = ',';
+        p += formatFixed(frame.max[ch], p);
+        *p++ = ',';
+        p += formatFixed(frame.variance[ch], p);
+    }
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
@@ -0,0 +1,182 @@
+#include "RealTime.h"
+#include "Logger.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <alloca.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+bool parseRealTimeCpus(const char* arg, RealTimeConfig& config) {
+    config.network_cpus.clear();
+    const char* p = arg;
+    bool first = true;
+    while (*p) {
+        char* end;
+        long cpu = strtol(p, &end, 10);
+        if (end == p || cpu < -1) return false;
+        if (first) config.timing_cpu = (int)cpu;
+        else config.network_cpus.push_back((int)cpu);
+        first = false;
+        p = end;
+        if (*p == ',') ++p;
+        else if (*p) return false;
+    }
+    return !first;
+}
+
+bool parseRealTimePriorities(const char* arg, RealTimeConfig& config) {
+    char* end;
+    long timing = strtol(arg, &end, 10);
+    long network = 0;
+    if (end == arg) return false;
+    if (*end == ':') {
+        const char* p = end + 1;
+        network = strtol(p, &end, 10);
+        if (end == p) return false;
+    }
+    if (*end || timing < 0 || timing > 99 || network < 0 || network > 99) return false;
+    config.timing_priority = (int)timing;
+    config.network_priority = (int)network;
+    return true;
+}
+
+namespace {
+
+// Thiết lập của lockMemory, ghi trước khi tạo các thread nên thread đọc không cần đồng bộ
+struct MemoryProfile {
+    bool enabled;
+    bool lock_threads;      // chỉ MCL_CURRENT: vùng pre-fault của thread mới phải mlock riêng
+    size_t stack;
+    size_t thread_heap;
+};
+
+MemoryProfile memory_profile = { false, false, 0, 0 };
+
+// Không inline để mảng thật sự nằm trên stack của thread gọi
+bool __attribute__((noinline)) prefaultStack(size_t bytes, bool lock) {
+    if (bytes == 0) return true;
+    volatile char* stack = (volatile char*)alloca(bytes);
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < bytes; i += page) stack[i] = 0;
+    return !lock || mlock((const void*)stack, bytes) == 0;
+}
+
+// Khối heap được giữ lại trong arena của thread (M_TRIM_THRESHOLD = -1), khóa trước khi free
+bool prefaultHeap(size_t bytes, bool lock) {
+    if (bytes == 0) return true;
+    char* heap = (char*)malloc(bytes);
+    if (!heap) return false;
+    long page = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < bytes; i += page) heap[i] = 0;
+    bool locked = !lock || mlock(heap, bytes) == 0;
+    free(heap);
+    return locked;
+}
+
+void prefaultThread(const char* name) {
+    bool lock = memory_profile.lock_threads;
+    bool locked = prefaultStack(memory_profile.stack, lock);
+    locked = prefaultHeap(memory_profile.thread_heap, lock) && locked;
+    locked = Logger::instance().prepareThread(lock) && locked;
+    if (!lock) {
+        LOG_INFO("Real-time: %s thread stack, heap and log ring prefaulted", name);
+    } else if (locked) {
+        LOG_INFO("Real-time: %s thread stack, heap and log ring prefaulted and locked", name);
+    } else {
+        LOG_INFO("Real-time: %s thread prefaulted but mlock failed (%s), its pages stay pageable", name,
+                 strerror(errno));
+    }
+}
+
+// CAP_IPC_LOCK trong tập hiệu lực: RLIMIT_MEMLOCK không áp dụng
+bool hasIpcLock() {
+    const int CAP_IPC_LOCK_BIT = 14;
+    FILE* status = fopen("/proc/self/status", "r");
+    if (!status) return false;
+    char line[128];
+    unsigned long long caps = 0;
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), status)) {
+        found = sscanf(line, "CapEff: %llx", &caps) == 1;
+    }
+    fclose(status);
+    return found && (caps >> CAP_IPC_LOCK_BIT) & 1;
+}
+
+} // namespace
+
+void applyThreadProfile(const char* name, int cpu, int priority) {
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) LOG_INFO("Real-time: cannot pin %s thread to CPU %d (%s), not pinned", name, cpu, strerror(err));
+        else LOG_INFO("Real-time: %s thread pinned to CPU %d", name, cpu);
+    }
+    if (priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0) {
+            LOG_INFO("Real-time: cannot use SCHED_FIFO %d for %s thread (%s), staying on SCHED_OTHER",
+                     priority, name, strerror(err));
+        } else {
+            LOG_INFO("Real-time: %s thread running SCHED_FIFO priority %d", name, priority);
+        }
+    }
+    if (memory_profile.enabled) prefaultThread(name);
+}
+
+void lockMemory(size_t prefault_stack, size_t prefault_heap, size_t thread_heap) {
+    // Heap: không trả bộ nhớ đã free về kernel và không dùng mmap riêng cho khối lớn,
+    // để vùng chạm trước (và được khóa) được malloc dùng lại
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    long page = sysconf(_SC_PAGESIZE);
+    if (prefault_heap > 0) {
+        char* heap = (char*)malloc(prefault_heap);
+        if (heap) {
+            for (size_t i = 0; i < prefault_heap; i += page) heap[i] = 0;
+            free(heap);
+        }
+    }
+    prefaultStack(prefault_stack, false);
+
+    memory_profile.enabled = true;
+    memory_profile.stack = prefault_stack;
+    memory_profile.thread_heap = thread_heap;
+
+    struct rlimit limit;
+    bool unlimited = getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur == RLIM_INFINITY;
+    bool future = unlimited || hasIpcLock();
+    if (mlockall(future ? (MCL_CURRENT | MCL_FUTURE) : MCL_CURRENT) != 0) {
+        // Thread mới vẫn được pre-fault, chỉ không khóa
+        int err = errno;
+        LOG_INFO("Real-time: mlockall failed (%s), memory stays pageable", strerror(err));
+        fprintf(stderr, "WARNING: real-time: mlockall failed (%s), memory stays pageable\n", strerror(err));
+        return;
+    }
+    if (future) {
+        LOG_INFO("Real-time: memory locked (current and future mappings)");
+        return;
+    }
+
+    // Chỉ khóa các mapping hiện có: stack/arena của thread tạo sau, history, recorder và
+    // mọi mmap về sau vẫn có thể bị page fault. Cảnh báo ra stderr để thấy cả khi -l off.
+    memory_profile.lock_threads = true;
+    LOG_INFO("Real-time: memory locked (current mappings only, RLIMIT_MEMLOCK is limited)");
+    fprintf(stderr,
+            "WARNING: real-time: MCL_FUTURE not applied (RLIMIT_MEMLOCK is %llu bytes and no CAP_IPC_LOCK), "
+            "memory mapped from now on is not locked; thread stacks are prefaulted and locked one by one. "
+            "Run with 'ulimit -l unlimited' or CAP_IPC_LOCK to lock everything.\n",
+            (unsigned long long)limit.rlim_cur);
+}
@@ -0,0 +1,256 @@
+#include "Recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+const size_t MIN_SEGMENT_BYTES = 64 * 1024;
+const int POLL_INTERVAL_MS = 50;
+
+size_t pageFloor(size_t offset) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return offset / page * page;
+}
+
+} // namespace
+
+FlightRecorder::FlightRecorder(const std::string& directory, size_t segment_bytes, int flush_interval_ms,
+                               unsigned max_segments)
+    : directory(directory), segment_bytes(segment_bytes > MIN_SEGMENT_BYTES ? segment_bytes : MIN_SEGMENT_BYTES),
+      flush_interval_ms(flush_interval_ms > 0 ? flush_interval_ms : 1000), max_segments(max_segments),
+      next_number(0), active(NULL), current(NULL), spare(NULL), frames_recorded(0), frames_dropped(0),
+      running(false) {}
+
+FlightRecorder::~FlightRecorder() {
+    // Thread lấy mẫu phải dừng trước (Server dừng sampler trước khi hủy sink)
+    if (running.exchange(false)) pthread_join(thread, NULL);
+
+    Segment* unused = spare.exchange(NULL);
+    for (size_t i = 0; i < open_segments.size(); ++i) {
+        Segment* segment = open_segments[i];
+        std::string path = segment->path;
+        closeSegment(segment);
+        if (segment == unused) unlink(path.c_str());        // segment dự phòng chưa dùng
+        delete segment;
+    }
+    open_segments.clear();
+}
+
+bool FlightRecorder::open() {
+    if (mkdir(directory.c_str(), 0755) < 0 && errno != EEXIST) {
+        perror("Recorder directory creation failed");
+        return false;
+    }
+
+    // Tiếp nối số thứ tự sau các segment của lần chạy trước
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        perror("opendir failed");
+        return false;
+    }
+    std::vector<unsigned> numbers;
+    while (struct dirent* entry = readdir(dir)) {
+        unsigned number;
+        char tail[8];
+        if (sscanf(entry->d_name, "flight-%u.%7s", &number, tail) == 2 && strcmp(tail, "rec") == 0) {
+            numbers.push_back(number);
+        }
+    }
+    closedir(dir);
+    std::sort(numbers.begin(), numbers.end());
+    for (size_t i = 0; i < numbers.size(); ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "/flight-%06u.rec", numbers[i]);
+        finished_paths.push_back(directory + name);
+    }
+    next_number = numbers.empty() ? 0 : numbers.back() + 1;
+
+    if (max_segments == 1) {
+        fprintf(stderr, "Recorder keeps at least 2 segments (active + preallocated next), using 2\n");
+        max_segments = 2;
+    }
+    // Xóa file cũ trước khi tạo segment mới để số file trên đĩa không vượt max_segments
+    removeOldSegments();
+    active = createSegment();
+    if (!active) return false;
+    current.store(active, std::memory_order_release);
+    spare.store(createSegment(), std::memory_order_release);
+
+    running = true;
+    if (pthread_create(&thread, NULL, flushThread, this) != 0) {
+        perror("Recorder thread creation failed");
+        running = false;
+        return false;
+    }
+    return true;
+}
+
+FlightRecorder::Segment* FlightRecorder::createSegment() {
+    char name[32];
+    snprintf(name, sizeof(name), "/flight-%06u.rec", next_number);
+    std::string path = directory + name;
+
+    int fd = ::open(path.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("Recorder segment creation failed");
+        return NULL;
+    }
+    // Cấp phát block trước: ghi qua mmap vào file thưa có thể SIGBUS khi đĩa đầy
+    int err = posix_fallocate(fd, 0, segment_bytes);
+    if (err != 0) {
+        fprintf(stderr, "Recorder segment allocation failed: %s\n", strerror(err));
+        close(fd);
+        unlink(path.c_str());
+        return NULL;
+    }
+    // MAP_POPULATE: page fault xảy ra ở đây (thread nền) thay vì trên thread lấy mẫu
+    void* mapping = mmap(NULL, segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        perror("Recorder mmap failed");
+        close(fd);
+        unlink(path.c_str());
+        return NULL;
+    }
+
+    Segment* segment = new Segment();
+    segment->number = next_number++;
+    segment->path = path;
+    segment->fd = fd;
+    segment->mapping = static_cast<char*>(mapping);
+    segment->size = segment_bytes;
+    segment->header = reinterpret_cast<RecorderHeader*>(segment->mapping);
+    segment->index = reinterpret_cast<RecorderIndexEntry*>(segment->header + 1);
+
+    // Đủ mục index cho trường hợp mọi frame đều nhỏ nhất (chỉ header)
+    uint32_t index_capacity = (uint32_t)(segment_bytes / (RECORDER_INDEX_INTERVAL * FRAME_HEADER_SIZE) + 1);
+    size_t data_offset = sizeof(RecorderHeader) + index_capacity * sizeof(RecorderIndexEntry);
+    data_offset = (data_offset + 63) & ~(size_t)63;
+    segment->data = segment->mapping + data_offset;
+    segment->data_capacity = segment_bytes - data_offset;
+    segment->used.store(0, std::memory_order_relaxed);
+    segment->synced = 0;
+
+    RecorderHeader* header = segment->header;
+    memset(header, 0, sizeof(*header));
+    header->magic = RECORDER_MAGIC;
+    header->version = RECORDER_VERSION;
+    header->segment = segment->number;
+    header->index_interval = RECORDER_INDEX_INTERVAL;
+    header->index_capacity = index_capacity;
+    header->data_offset = data_offset;
+
+    open_segments.push_back(segment);
+    return segment;
+}
+
+void FlightRecorder::onSample(const SampleFrame& frame) {
+    Segment* segment = active;
+    size_t size = frameSize(frame.channel_mask);
+    size_t used = segment->used.load(std::memory_order_relaxed);
+
+    if (used + size > segment->data_capacity) {
+        // Xoay sang segment dự phòng; chưa có (đĩa chậm) thì bỏ mẫu thay vì chờ
+        Segment* next = spare.exchange(NULL, std::memory_order_acq_rel);
+        if (!next) {
+            frames_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        active = segment = next;
+        current.store(segment, std::memory_order_release);
+        used = 0;
+    }
+
+    RecorderHeader* header = segment->header;
+    if (header->frame_count % RECORDER_INDEX_INTERVAL == 0) {
+        RecorderIndexEntry& entry = segment->index[header->index_count++];
+        entry.timestamp_us = frame.timestamp_us;
+        entry.offset = used;
+    }
+    encodeFrame(frame, segment->data + used);
+
+    if (header->frame_count == 0) header->first_timestamp_us = frame.timestamp_us;
+    header->last_timestamp_us = frame.timestamp_us;
+    ++header->frame_count;
+    header->data_bytes = used + size;
+    segment->used.store(used + size, std::memory_order_release);
+    frames_recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* FlightRecorder::flushThread(void* arg) {
+    static_cast<FlightRecorder*>(arg)->runFlush();
+    return NULL;
+}
+
+void FlightRecorder::runFlush() {
+    auto next_flush = std::chrono::steady_clock::now() + std::chrono::milliseconds(flush_interval_ms);
+
+    while (running.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+
+        // Segment có số nhỏ hơn current đã bị thay: thread lấy mẫu không còn ghi vào nữa
+        Segment* segment = current.load(std::memory_order_acquire);
+        for (size_t i = 0; i < open_segments.size();) {
+            Segment* old = open_segments[i];
+            if (old->number >= segment->number) {
+                ++i;
+                continue;
+            }
+            finished_paths.push_back(old->path);
+            closeSegment(old);
+            delete old;
+            open_segments.erase(open_segments.begin() + i);
+            removeOldSegments();
+        }
+
+        // Tạo sau khi đã xóa file cũ: spare nằm trong giới hạn max_segments
+        if (!spare.load(std::memory_order_acquire)) spare.store(createSegment(), std::memory_order_release);
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_flush) {
+            syncSegment(segment, false);
+            next_flush = now + std::chrono::milliseconds(flush_interval_ms);
+        }
+    }
+}
+
+void FlightRecorder::syncSegment(Segment* segment, bool final) {
+    size_t used = segment->used.load(std::memory_order_acquire);
+    if (used == segment->synced && !final) return;
+
+    // Header và index (đầu file) cùng vùng frame mới ghi kể từ lần trước
+    size_t data_offset = segment->data - segment->mapping;
+    if (msync(segment->mapping, data_offset, MS_SYNC) < 0) perror("msync failed");
+    size_t from = pageFloor(data_offset + segment->synced);
+    size_t to = data_offset + used;
+    if (to > from && msync(segment->mapping + from, to - from, MS_SYNC) < 0) perror("msync failed");
+    segment->synced = used;
+}
+
+void FlightRecorder::closeSegment(Segment* segment) {
+    syncSegment(segment, true);
+    size_t length = (segment->data - segment->mapping) + segment->used.load(std::memory_order_acquire);
+    munmap(segment->mapping, segment->size);
+    // Trả lại phần cấp phát trước chưa dùng
+    if (ftruncate(segment->fd, length) < 0) perror("ftruncate failed");
+    if (fdatasync(segment->fd) < 0) perror("fdatasync failed");
+    close(segment->fd);
+}
+
+void FlightRecorder::removeOldSegments() {
+    if (max_segments == 0) return;
+    // Segment đang ghi và segment dự phòng (đã cấp phát trên đĩa) cũng được tính
+    while (!finished_paths.empty() && finished_paths.size() + 2 > max_segments) {
+        unlink(finished_paths.front().c_str());
+        finished_paths.erase(finished_paths.begin());
+    }
+}
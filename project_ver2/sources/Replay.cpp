@@ -0,0 +1,162 @@
+#include "Replay.h"
+#include "Recorder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+const size_t PREFETCH_BYTES = 4 * 1024 * 1024;
+const size_t CSV_LINE_MAX = 256;
+
+} // namespace
+
+ReplayFile::ReplayFile(const std::string& path)
+    : file_path(path), mapping(NULL), mapping_size(0), csv(false), begin(NULL), end(NULL), pos(NULL),
+      prefetched(NULL), frame_count(0), first_timestamp_us(0), last_timestamp_us(0) {}
+
+ReplayFile::~ReplayFile() {
+    if (mapping) munmap((void*)mapping, mapping_size);
+}
+
+bool ReplayFile::open() {
+    int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("Replay file open failed");
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        fprintf(stderr, "Replay file %s is empty\n", file_path.c_str());
+        close(fd);
+        return false;
+    }
+    mapping_size = st.st_size;
+    void* address = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        perror("Replay mmap failed");
+        return false;
+    }
+    mapping = static_cast<const char*>(address);
+    madvise(address, mapping_size, MADV_SEQUENTIAL);
+
+    const RecorderHeader* header = reinterpret_cast<const RecorderHeader*>(mapping);
+    if (mapping_size >= sizeof(RecorderHeader) && header->magic == RECORDER_MAGIC) {
+        if (header->version != RECORDER_VERSION || header->data_offset + header->data_bytes > mapping_size) {
+            fprintf(stderr, "Replay file %s is an incompatible recorder segment\n", file_path.c_str());
+            return false;
+        }
+        begin = mapping + header->data_offset;
+        end = begin + header->data_bytes;
+        frame_count = header->frame_count;
+        first_timestamp_us = header->first_timestamp_us;
+        last_timestamp_us = header->last_timestamp_us;
+    } else {
+        // CSV: đếm số dòng dữ liệu và lấy timestamp đầu/cuối bằng một lượt quét
+        csv = true;
+        begin = mapping;
+        end = mapping + mapping_size;
+        rewind();
+        SampleFrame frame;
+        while (nextCsv(frame)) {
+            if (frame_count == 0) first_timestamp_us = frame.timestamp_us;
+            last_timestamp_us = frame.timestamp_us;
+            ++frame_count;
+        }
+    }
+
+    rewind();
+    if (frame_count == 0) {
+        fprintf(stderr, "Replay file %s contains no samples\n", file_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ReplayFile::rewind() {
+    pos = begin;
+    prefetched = begin;
+    prefetch();
+    return true;
+}
+
+void ReplayFile::prefetch() {
+    // Giữ trước vị trí đọc ít nhất nửa cửa sổ đọc trước
+    if (prefetched - pos > (ptrdiff_t)(PREFETCH_BYTES / 2) || prefetched >= end) return;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const char* from = mapping + (size_t)(prefetched - mapping) / page * page;
+    size_t length = (size_t)(end - from) < PREFETCH_BYTES ? (size_t)(end - from) : PREFETCH_BYTES;
+    madvise((void*)from, length, MADV_WILLNEED);
+    prefetched = from + length;
+}
+
+bool ReplayFile::next(SampleFrame& frame) {
+    prefetch();
+    return csv ? nextCsv(frame) : nextRecorded(frame);
+}
+
+int ReplayFile::read(SampleFrame* frames, size_t max) {
+    size_t count = 0;
+    while (count < max && next(frames[count])) ++count;
+    return count > 0 ? (int)count : -1;
+}
+
+bool ReplayFile::nextRecorded(SampleFrame& frame) {
+    if (pos >= end) return false;
+    int used = decodeFrame(pos, end - pos, frame);
+    if (used <= 0) {
+        // Segment bị cắt giữa chừng (ví dụ mất điện) hoặc hỏng: dừng ở frame hợp lệ cuối
+        pos = end;
+        return false;
+    }
+    pos += used;
+    return true;
+}
+
+bool ReplayFile::nextCsv(SampleFrame& frame) {
+    while (pos < end) {
+        const char* line_end = (const char*)memchr(pos, '\n', end - pos);
+        if (!line_end) line_end = end;
+
+        // File được map không kết thúc '\0': copy dòng ra buffer trước khi strtod
+        char line[CSV_LINE_MAX];
+        size_t len = line_end - pos < (ptrdiff_t)(CSV_LINE_MAX - 1) ? line_end - pos : CSV_LINE_MAX - 1;
+        memcpy(line, pos, len);
+        line[len] = '\0';
+        pos = line_end < end ? line_end + 1 : end;
+
+        char* p = line;
+        char* next;
+        unsigned long long timestamp = strtoull(p, &next, 10);
+        if (next == p) continue;
+        frame.timestamp_us = timestamp;
+        frame.sequence = 0;
+        frame.channel_mask = 0;
+        p = next;
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            frame.values[ch] = 0.0;
+            if (*p != ',') continue;
+            double value = strtod(p + 1, &next);
+            if (next == p + 1) {
+                ++p;            // ô trống: kênh không có trong mẫu này
+                continue;
+            }
+            frame.values[ch] = value;
+            frame.channel_mask |= channelBit(ch);
+            p = next;
+        }
+        if (frame.channel_mask) return true;
+    }
+    return false;
+}
+
+double ReplayFile::rateHz() const {
+    if (frame_count < 2 || last_timestamp_us <= first_timestamp_us) return 0.0;
+    return (frame_count - 1) * 1e6 / (double)(last_timestamp_us - first_timestamp_us);
+}
@@ -0,0 +1,169 @@
+#include "Sampler.h"
+#include "Logger.h"
+#include "RealTime.h"
+
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+
+Sampler::Sampler(double rate_hz)
+    : rate_hz(rate_hz > 0 ? rate_hz : 600.0), seq(0), next_sequence(0), source(&simulator), speed(1.0),
+      loop(false), block_len(0), block_pos(0), rebase(true), origin_us(0), thread_cpu(-1),
+      thread_priority(0), running(false) {
+    for (int i = 0; i < PAYLOAD_WORDS; ++i) payload[i].store(0, std::memory_order_relaxed);
+}
+
+Sampler::~Sampler() {
+    stop();
+}
+
+void Sampler::setSource(SensorSource* new_source, double new_speed, bool new_loop) {
+    source = new_source;
+    speed = new_speed > 0 ? new_speed : 0.0;
+    loop = new_loop;
+    // Nhịp đẩy của SUBSCRIBE/AGGREGATE dựa trên rateHz(): lấy theo nhịp riêng của nguồn
+    double source_rate = source->rateHz();
+    if (source->clock() == SOURCE_CLOCK_RECORDED && speed > 0 && source_rate > 0) {
+        rate_hz = source_rate * speed;
+    } else if (source->clock() == SOURCE_CLOCK_DEVICE && source_rate > 0) {
+        rate_hz = source_rate;
+    }
+}
+
+void Sampler::start() {
+    if (running.load()) return;
+
+    // Công bố mẫu đầu tiên ngay (nguồn thiết bị có thể chờ tới khi có dữ liệu)
+    running = true;
+    next_tick = std::chrono::steady_clock::now();
+    rebase = true;
+    SampleFrame frame;
+    if (!acquire(frame)) {
+        fprintf(stderr, "Sensor source %s has no samples\n", source->name());
+        running = false;
+        return;
+    }
+    publish(frame);
+
+    if (pthread_create(&thread, NULL, samplingThread, this) != 0) {
+        perror("Sampling thread creation failed");
+        running = false;
+    }
+}
+
+void Sampler::stop() {
+    if (!running.exchange(false)) return;
+    pthread_join(thread, NULL);
+}
+
+void* Sampler::samplingThread(void* arg) {
+    Sampler* sampler = static_cast<Sampler*>(arg);
+    applyThreadProfile("sampling", sampler->thread_cpu, sampler->thread_priority);
+    sampler->run();
+    return NULL;
+}
+
+void Sampler::run() {
+    SampleFrame frame;
+
+    while (running.load(std::memory_order_relaxed)) {
+        if (!acquire(frame)) {
+            LOG_INFO("Sensor source %s finished", source->name());
+            break;
+        }
+        publish(frame);
+    }
+}
+
+bool Sampler::nextFromBlock(SampleFrame& frame) {
+    while (block_pos == block_len) {
+        int n = source->read(block, BLOCK_SAMPLES);
+        if (n > 0) {
+            block_len = n;
+            block_pos = 0;
+        } else if (n < 0) {
+            if (!loop || !source->rewind()) return false;
+            rebase = true;
+        } else if (!running.load(std::memory_order_relaxed)) {
+            return false;
+        }
+    }
+    frame = block[block_pos++];
+    return true;
+}
+
+bool Sampler::acquire(SampleFrame& frame) {
+    if (!nextFromBlock(frame)) return false;
+
+    switch (source->clock()) {
+    case SOURCE_CLOCK_SAMPLER: {
+        const auto period = std::chrono::nanoseconds(static_cast<long long>(1e9 / rate_hz));
+        std::this_thread::sleep_until(next_tick);
+        auto now = std::chrono::steady_clock::now();
+        int64_t late_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - next_tick).count();
+        wakeup_jitter.record(late_ns > 0 ? late_ns : 0);
+        next_tick += period;
+        if (next_tick < now) next_tick = now + period;    // bị trễ: bỏ qua các tick đã lỡ
+        break;
+    }
+    case SOURCE_CLOCK_RECORDED:
+        if (rebase) {
+            origin_us = frame.timestamp_us;
+            origin = std::chrono::steady_clock::now();
+            rebase = false;
+        } else if (speed > 0 && frame.timestamp_us > origin_us) {
+            // Giữ khoảng cách giữa các mẫu như lúc ghi (chia cho speed). Bị trễ thì không bỏ
+            // mẫu mà phát bù ngay để phát lại đủ dữ liệu.
+            auto offset = std::chrono::nanoseconds(
+                static_cast<long long>((frame.timestamp_us - origin_us) * 1000.0 / speed));
+            std::this_thread::sleep_until(origin + offset);
+            int64_t late_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - (origin + offset)).count();
+            wakeup_jitter.record(late_ns > 0 ? late_ns : 0);
+        }
+        break;
+    case SOURCE_CLOCK_DEVICE:
+        frame.sequence = next_sequence++;
+        return true;
+    }
+
+    frame.sequence = next_sequence++;
+    frame.timestamp_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return true;
+}
+
+void Sampler::publish(const SampleFrame& frame) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    payload[0].store(frame.sequence | ((uint64_t)frame.channel_mask << 32), std::memory_order_relaxed);
+    payload[1].store(frame.timestamp_us, std::memory_order_relaxed);
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        uint64_t bits;
+        memcpy(&bits, &frame.values[ch], sizeof(bits));
+        payload[2 + ch].store(bits, std::memory_order_relaxed);
+    }
+
+    seq.store(s + 2, std::memory_order_release);
+
+    for (size_t i = 0; i < sinks.size(); ++i) sinks[i]->onSample(frame);
+}
+
+void Sampler::latest(SampleFrame& frame) const {
+    uint64_t words[PAYLOAD_WORDS];
+    uint32_t before, after;
+    do {
+        before = seq.load(std::memory_order_acquire);
+        for (int i = 0; i < PAYLOAD_WORDS; ++i) words[i] = payload[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = seq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    frame.sequence = (uint32_t)words[0];
+    frame.channel_mask = (ChannelMask)(words[0] >> 32);
+    frame.timestamp_us = words[1];
+    for (int ch = 0; ch < CH_COUNT; ++ch) memcpy(&frame.values[ch], &words[2 + ch], sizeof(double));
+}
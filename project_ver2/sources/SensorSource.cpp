@@ -0,0 +1,146 @@
+#include "SensorSource.h"
+
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const int DEVICE_POLL_MS = 100;     // để Sampler kiểm tra cờ dừng khi thiết bị im lặng
+
+} // namespace
+
+SimulatedSource::SimulatedSource()
+    : rng(std::chrono::steady_clock::now().time_since_epoch().count()) {
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        dist[ch] = std::uniform_real_distribution<double>(CHANNELS[ch].min, CHANNELS[ch].max);
+    }
+}
+
+int SimulatedSource::read(SampleFrame* frames, size_t max) {
+    for (size_t i = 0; i < max; ++i) {
+        SampleFrame& frame = frames[i];
+        frame.channel_mask = CHANNEL_MASK_ALL;
+        frame.timestamp_us = 0;
+        for (int ch = 0; ch < CH_COUNT; ++ch) frame.values[ch] = dist[ch](rng);
+    }
+    return (int)max;
+}
+
+MockSource::MockSource() : index(0) {}
+
+void MockSource::expected(uint64_t index, SampleFrame& frame) {
+    frame.channel_mask = CHANNEL_MASK_ALL;
+    frame.timestamp_us = 0;
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        uint64_t period = 1000u << ch;
+        frame.values[ch] = CHANNELS[ch].min +
+                           (CHANNELS[ch].max - CHANNELS[ch].min) * (double)(index % period) / (double)period;
+    }
+}
+
+int MockSource::read(SampleFrame* frames, size_t max) {
+    for (size_t i = 0; i < max; ++i) expected(index++, frames[i]);
+    return (int)max;
+}
+
+DeviceCalibration::DeviceCalibration() {
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        scale[ch] = CHANNELS[ch].scale;
+        offset[ch] = CHANNELS[ch].offset;
+    }
+}
+
+bool parseDeviceCalibration(const char* arg, DeviceCalibration& calibration) {
+    const char* p = arg;
+    while (*p) {
+        // TAG=scale[:offset]
+        int ch = channelFromTag(p[0], p[0] ? p[1] : 0);
+        if (ch < 0 || p[2] != '=') return false;
+        char* end;
+        double scale = strtod(p + 3, &end);
+        if (end == p + 3) return false;
+        double offset = calibration.offset[ch];
+        if (*end == ':') {
+            const char* offset_arg = end + 1;
+            offset = strtod(offset_arg, &end);
+            if (end == offset_arg) return false;
+        }
+        if (*end != ',' && *end != '\0') return false;
+        calibration.scale[ch] = scale;
+        calibration.offset[ch] = offset;
+        p = *end ? end + 1 : end;
+    }
+    return true;
+}
+
+DeviceSource::DeviceSource(const std::string& path, double rate_hz, const DeviceCalibration& calibration)
+    : path(path), rate_hz(rate_hz), fd(-1), regular_file(false), calibration(calibration), buffered(0) {}
+
+DeviceSource::~DeviceSource() {
+    if (fd >= 0) close(fd);
+}
+
+bool DeviceSource::open() {
+    fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        perror("Sensor device open failed");
+        return false;
+    }
+    struct stat st;
+    regular_file = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    return true;
+}
+
+int DeviceSource::read(SampleFrame* frames, size_t max) {
+    size_t want = max * RECORD_SIZE < sizeof(buffer) ? max * RECORD_SIZE : sizeof(buffer);
+
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    int ready = poll(&pfd, 1, DEVICE_POLL_MS);
+    if (ready < 0 && errno != EINTR) {
+        perror("Sensor device poll failed");
+        return -1;
+    }
+    if (ready <= 0) return 0;
+
+    ssize_t n = ::read(fd, buffer + buffered, want - buffered);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EINTR) return 0;
+        perror("Sensor device read failed");
+        return -1;
+    }
+    if (n == 0) return -1;      // file thường đã hết
+    buffered += n;
+
+    size_t count = buffered / RECORD_SIZE;
+    uint64_t now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint64_t period_us = rate_hz > 0 ? (uint64_t)(1e6 / rate_hz) : 0;
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char* record = (const unsigned char*)buffer + i * RECORD_SIZE;
+        SampleFrame& frame = frames[i];
+        frame.channel_mask = CHANNEL_MASK_ALL;
+        frame.timestamp_us = now_us - (count - 1 - i) * period_us;
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            int16_t raw = (int16_t)(record[2 * ch] | (record[2 * ch + 1] << 8));
+            frame.values[ch] = (raw + calibration.offset[ch]) * calibration.scale[ch];
+        }
+    }
+
+    buffered -= count * RECORD_SIZE;
+    memmove(buffer, buffer + count * RECORD_SIZE, buffered);
+    return (int)count;
+}
+
+bool DeviceSource::rewind() {
+    buffered = 0;
+    return lseek(fd, 0, SEEK_SET) == 0;
+}
@@ -1,114 +1,1333 @@
 #include "Server.h"
 
-std::mt19937 rng(std::chrono::steady_clock::now().time_since_epoch().count());
-std::uniform_real_distribution<double> azimuth_dist(0.0, 360.0);
-std::uniform_real_distribution<double> elevation_dist(0.0, 90.0);
-std::uniform_real_distribution<double> temp_dist(20.0, 30.0);
-std::uniform_real_distribution<double> humidity_dist(40.0, 80.0);
+#include <strings.h>
 
-Server::Server(int port) : port(port), server_fd(-1) {}
+Server::Server(int port) : shared_listener(false), unix_listener(-1), sampler(config.sample_rate_hz), stats_running(false) {
+    config.port = port;
+    Logger::instance().setLevel(config.log_level);
+}
+
+Server::Server(const ServerConfig& config)
+    : config(config), shared_listener(false), unix_listener(-1), sampler(config.sample_rate_hz), stats_running(false) {
+    Logger::instance().setLevel(config.log_level);
+}
 
 Server::~Server() {
-    if (server_fd >= 0) close(server_fd);
+    // Sink (multicast, shm, aggregate) bị hủy cùng Server: dừng thread lấy mẫu trước
+    sampler.stop();
+    if (stats_running.exchange(false)) pthread_join(stats_thread, NULL);
+    for (size_t i = 0; i < reactors.size(); ++i) {
+        Slab<Connection>& connections = reactors[i].connections;
+        for (size_t c = 0; c < connections.highWater(); ++c) {
+            if (connections[c].fd < 0) continue;
+            releaseFrames(connections[c]);
+            close(connections[c].fd);
+        }
+        for (int f = 0; f < 2; ++f) {
+            if (reactors[i].cached_frames[f]) reactors[i].cached_frames[f]->release();
+            for (int a = 0; a < AggregatorSet::MAX_AGGREGATES; ++a) {
+                if (reactors[i].aggregate_frames[a][f]) reactors[i].aggregate_frames[a][f]->release();
+            }
+        }
+        if (reactors[i].timer_fd >= 0) close(reactors[i].timer_fd);
+        if (reactors[i].aggregate_fd >= 0) close(reactors[i].aggregate_fd);
+        if (reactors[i].epoll_fd >= 0) close(reactors[i].epoll_fd);
+        if (reactors[i].listen_fd >= 0 && !(shared_listener && i > 0)) close(reactors[i].listen_fd);
+    }
+    if (unix_listener >= 0) {
+        close(unix_listener);
+        unlink(config.unix_path.c_str());
+    }
 }
 
-void Server::start() {
+int Server::createListenSocket(bool reuse_port) {
     struct sockaddr_in address;
     int opt = 1;
-    socklen_t addrlen = sizeof(address);
+    int fd;
 
-    if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0) {
+    if ((fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
         perror("Socket failed");
         exit(EXIT_FAILURE);
     }
 
-    fcntl(server_fd, F_SETFL, O_NONBLOCK);
-
-    if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt))) {
         perror("Setsockopt failed");
         exit(EXIT_FAILURE);
     }
 
+    if (reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt))) {
+        close(fd);
+        return -1;
+    }
+
     address.sin_family = AF_INET;
     address.sin_addr.s_addr = INADDR_ANY;
-    address.sin_port = htons(port);
+    address.sin_port = htons(config.port);
 
-    if (bind(server_fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
         perror("Bind failed");
         exit(EXIT_FAILURE);
     }
 
-    if (listen(server_fd, 10) < 0) {
+    if (listen(fd, SOMAXCONN) < 0) {
+        perror("Listen failed");
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+int Server::createUnixSocket() {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (config.unix_path.size() >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Unix socket path too long: %s\n", config.unix_path.c_str());
+        exit(EXIT_FAILURE);
+    }
+    strcpy(address.sun_path, config.unix_path.c_str());
+
+    int type = config.unix_seqpacket ? SOCK_SEQPACKET : SOCK_STREAM;
+    int fd = socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("Unix socket failed");
+        exit(EXIT_FAILURE);
+    }
+
+    // Socket file còn sót lại từ lần chạy trước
+    unlink(config.unix_path.c_str());
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        perror("Unix bind failed");
+        exit(EXIT_FAILURE);
+    }
+
+    if (listen(fd, SOMAXCONN) < 0) {
         perror("Listen failed");
         exit(EXIT_FAILURE);
     }
+    return fd;
+}
+
+void Server::addListener(Reactor& reactor, int listen_fd, bool exclusive) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    if (exclusive) ev.events |= EPOLLEXCLUSIVE;
+    ev.data.fd = listen_fd;
+    if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev) < 0) {
+        perror("epoll_ctl failed");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void Server::setupReactors() {
+    int count = config.num_threads > 0 ? config.num_threads : 1;
+    reactors.resize(count);
+    size_t per_reactor = (config.max_connections + count - 1) / count;
+    if (per_reactor == 0) per_reactor = 1;
+    if (!config.unix_path.empty()) unix_listener = createUnixSocket();
+
+    for (int i = 0; i < count; ++i) {
+        Reactor& reactor = reactors[i];
+        reactor.server = this;
+        reactor.index = i;
+        reactor.listen_fd = -1;
+        reactor.unix_fd = unix_listener;
+        reactor.cached_frames[0] = reactor.cached_frames[1] = NULL;
+        memset(reactor.aggregate_frames, 0, sizeof(reactor.aggregate_frames));
+        reactor.samples_sent = 0;
+        reactor.frames_encoded = 0;
+        reactor.frames_dropped = 0;
+        reactor.next_summary_ns = 0;
+        reactor.stats.reset(new ThreadStats());
+        reactor.timer_deadline_ns = 0;
+        reactor.timers = TimerWheel(TIMER_TICK_NS);
+        reactor.timers.reset(nowNs());
+
+        // Mọi đối tượng kết nối và buffer của chúng được cấp ở đây, accept/close về sau
+        // chỉ lấy và trả slot
+        reactor.connections.init(per_reactor);
+        for (size_t c = 0; c < per_reactor; ++c) {
+            Connection& conn = reactor.connections[c];
+            conn.fd = -1;
+            conn.in.reserve(IN_BUFFER_RESERVE);
+            conn.out.reserve(OUT_BUFFER_RESERVE);
+            conn.inflight.reserve(OUT_BUFFER_RESERVE);
+        }
+        reactor.by_fd.assign(config.max_connections + FD_TABLE_SLACK, NULL);
+
+        if ((reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+            perror("epoll_create1 failed");
+            exit(EXIT_FAILURE);
+        }
+
+        if ((reactor.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+            perror("timerfd_create failed");
+            exit(EXIT_FAILURE);
+        }
+
+        if ((reactor.aggregate_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+            perror("eventfd failed");
+            exit(EXIT_FAILURE);
+        }
+        aggregates.notifyOnResult(reactor.aggregate_fd);
+
+        // Nhiều reactor: ưu tiên SO_REUSEPORT để kernel tự chia kết nối.
+        // Nếu không hỗ trợ thì dùng chung listener đầu tiên với EPOLLEXCLUSIVE.
+        if (count > 1 && !shared_listener) {
+            reactor.listen_fd = createListenSocket(true);
+            if (reactor.listen_fd < 0) {
+                if (i > 0) {
+                    perror("SO_REUSEPORT failed");
+                    exit(EXIT_FAILURE);
+                }
+                shared_listener = true;
+            }
+        }
+        if (reactor.listen_fd < 0) {
+            reactor.listen_fd = (shared_listener && i > 0) ? reactors[0].listen_fd
+                                                           : createListenSocket(false);
+        }
+
+        addListener(reactor, reactor.listen_fd, shared_listener);
+        // AF_UNIX không có SO_REUSEPORT: một listener, mỗi kết nối chỉ đánh thức một reactor
+        if (reactor.unix_fd >= 0) addListener(reactor, reactor.unix_fd, count > 1);
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = reactor.timer_fd;
+        if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, reactor.timer_fd, &ev) < 0) {
+            perror("epoll_ctl failed");
+            exit(EXIT_FAILURE);
+        }
+        ev.data.fd = reactor.aggregate_fd;
+        if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, reactor.aggregate_fd, &ev) < 0) {
+            perror("epoll_ctl failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+    LOG_INFO("Connection pool: %zu slots per reactor, %zu KB preallocated", per_reactor,
+             count * per_reactor * (sizeof(Connection) + IN_BUFFER_RESERVE + 2 * OUT_BUFFER_RESERVE) / 1024);
+}
+
+void Server::start() {
+    setupReactors();
+
+    if (!config.multicast_group.empty()) {
+        multicast.reset(new MulticastPublisher(config.multicast_group, config.multicast_port,
+                                               config.multicast_ttl, config.multicast_interface));
+        if (!multicast->open()) exit(EXIT_FAILURE);
+        sampler.addSink(multicast.get());
+        LOG_INFO("Publishing samples to multicast group %s:%d", config.multicast_group.c_str(),
+                 config.multicast_port);
+    }
+    if (!config.shm_name.empty()) {
+        shm_ring.reset(new ShmRingWriter(config.shm_name, config.shm_slots));
+        if (!shm_ring->open()) exit(EXIT_FAILURE);
+        sampler.addSink(shm_ring.get());
+        LOG_INFO("Publishing samples to shared memory ring /dev/shm%s", shm_ring->path().c_str());
+    }
+    sampler.addSink(&aggregates);
+    if (!config.recorder_dir.empty()) {
+        recorder.reset(new FlightRecorder(config.recorder_dir, config.recorder_segment_bytes,
+                                          config.recorder_flush_ms, config.recorder_max_segments));
+        if (!recorder->open()) exit(EXIT_FAILURE);
+        sampler.addSink(recorder.get());
+        LOG_INFO("Recording all samples to %s (%zu KB segments)", config.recorder_dir.c_str(),
+                 config.recorder_segment_bytes / 1024);
+    }
+    if (config.history_bytes >= SampleHistory::BYTES_PER_SAMPLE) {
+        history.reset(new SampleHistory(config.history_bytes));
+        sampler.addSink(history.get());
+        LOG_INFO("Keeping %zu samples of history (%zu KB)", history->capacity(), history->bytes() / 1024);
+    }
+    if (!config.replay_path.empty()) {
+        ReplayFile* replay = new ReplayFile(config.replay_path);
+        source.reset(replay);
+        if (!replay->open()) exit(EXIT_FAILURE);
+        if (config.replay_speed > 0) {
+            LOG_INFO("Replaying %llu samples from %s at %gx%s", (unsigned long long)replay->frameCount(),
+                     config.replay_path.c_str(), config.replay_speed, config.replay_loop ? " (loop)" : "");
+        } else {
+            LOG_INFO("Replaying %llu samples from %s as fast as possible%s",
+                     (unsigned long long)replay->frameCount(), config.replay_path.c_str(),
+                     config.replay_loop ? " (loop)" : "");
+        }
+    } else if (config.sensor_source == "mock") {
+        source.reset(new MockSource());
+    } else if (config.sensor_source != "sim" && !config.sensor_source.empty()) {
+        source.reset(new DeviceSource(config.sensor_source, config.sample_rate_hz, config.device_calibration));
+        if (!source->open()) exit(EXIT_FAILURE);
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            LOG_INFO("Device channel %s: value = (raw + %g) * %g", CHANNELS[ch].tag,
+                     config.device_calibration.offset[ch], config.device_calibration.scale[ch]);
+        }
+    }
+    if (source) {
+        sampler.setSource(source.get(), config.replay_speed, config.replay_loop);
+        LOG_INFO("Reading sensor data from %s", source->name());
+    }
+    // Khóa bộ nhớ sau khi các buffer lớn (history, recorder, shm) đã được cấp phát
+    if (config.realtime.lock_memory) lockMemory(REALTIME_PREFAULT_STACK, REALTIME_PREFAULT_HEAP, REALTIME_PREFAULT_THREAD_HEAP);
+    sampler.setThreadProfile(config.realtime.timing_cpu, config.realtime.timing_priority);
+    sampler.start();
 
-    std::cout << "Z-turn Server listening on port " << port << "..." << std::endl;
+    LOG_INFO("Z-turn Server listening on port %d with %zu reactor thread(s)%s...", config.port,
+             reactors.size(),
+             reactors.size() > 1 ? (shared_listener ? " (EPOLLEXCLUSIVE)" : " (SO_REUSEPORT)") : "");
+    if (unix_listener >= 0) {
+        LOG_INFO("Also listening on unix socket %s (%s)", config.unix_path.c_str(),
+                 config.unix_seqpacket ? "SOCK_SEQPACKET" : "SOCK_STREAM");
+    }
+    LOG_INFO("Sampling all channels at %f Hz", sampler.rateHz());
 
+    if (config.stats_interval_s > 0) {
+        stats_running = true;
+        if (pthread_create(&stats_thread, NULL, statsThread, this) != 0) {
+            perror("Stats thread creation failed");
+            stats_running = false;
+        }
+    }
+
+    for (size_t i = 1; i < reactors.size(); ++i) {
+        if (pthread_create(&reactors[i].thread, NULL, reactorThread, &reactors[i]) != 0) {
+            perror("Thread creation failed");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Reactor 0 chạy trên thread gọi start()
+    reactors[0].thread = pthread_self();
+    runReactor(reactors[0]);
+
+    for (size_t i = 1; i < reactors.size(); ++i) {
+        pthread_join(reactors[i].thread, NULL);
+    }
+}
+
+void* Server::reactorThread(void* arg) {
+    Reactor* reactor = static_cast<Reactor*>(arg);
+    reactor->server->runReactor(*reactor);
+    return NULL;
+}
+
+void Server::runReactor(Reactor& reactor) {
+    char name[32];
+    snprintf(name, sizeof(name), "reactor %d", reactor.index);
+    applyThreadProfile(name, config.realtime.networkCpu(reactor.index), config.realtime.network_priority);
+
+#ifdef ZTURN_HAVE_IO_URING
+    if (config.use_io_uring && runUringReactor(reactor)) return;
+#endif
+
+    struct epoll_event events[MAX_EVENTS];
     while (true) {
-        int* new_socket = (int*)malloc(sizeof(int));
-        if ((*new_socket = accept(server_fd, (struct sockaddr*)&address, &addrlen)) < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                std::this_thread::sleep_for(std::chrono::microseconds(100));
-                free(new_socket);
+        // Chờ không giới hạn: không có sự kiện thì không tốn CPU
+        int nfds = epoll_wait(reactor.epoll_fd, events, MAX_EVENTS, -1);
+        if (nfds < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait failed");
+            break;
+        }
+
+        for (int i = 0; i < nfds; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == reactor.listen_fd || fd == reactor.unix_fd) {
+                acceptClients(reactor, fd);
                 continue;
             }
+
+            if (fd == reactor.timer_fd || fd == reactor.aggregate_fd) {
+                uint64_t expirations;
+                while (read(fd, &expirations, sizeof(expirations)) > 0) {}
+                if (fd == reactor.timer_fd) runTimers(reactor);
+                else pushAggregates(reactor);
+                for (size_t j = 0; j < reactor.ready.size(); ++j) {
+                    Connection* conn = findConnection(reactor, reactor.ready[j]);
+                    if (!conn) continue;
+                    if (conn->evicted) closeClient(reactor, conn->fd);
+                    else sendPending(*conn);
+                }
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeClient(reactor, fd);
+                continue;
+            }
+
+            if ((events[i].events & EPOLLIN) && !handleClient(reactor, fd)) {
+                closeClient(reactor, fd);
+                continue;
+            }
+
+            if ((events[i].events & EPOLLOUT) && !handleWritable(reactor, fd)) {
+                closeClient(reactor, fd);
+            }
+        }
+        logSummary(reactor);
+    }
+}
+
+void Server::acceptClients(Reactor& reactor, int listen_fd) {
+    // Edge-triggered: accept hết hàng đợi cho đến khi gặp EAGAIN
+    while (true) {
+        struct sockaddr_storage address;
+        socklen_t addrlen = sizeof(address);
+        int client_fd = accept4(listen_fd, (struct sockaddr*)&address, &addrlen,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR || errno == ECONNABORTED) continue;
             perror("Accept failed");
-            free(new_socket);
-            continue;
+            break;
         }
 
-        std::cout << "New client connected from "
-                  << inet_ntoa(((struct sockaddr_in*)&address)->sin_addr) << std::endl;
+        if (!addConnection(reactor, client_fd, peerName(address))) continue;
 
-        pthread_t thread_id;
-        if (pthread_create(&thread_id, NULL, handleClient, (void*)new_socket) < 0) {
-            perror("Thread creation failed");
-            close(*new_socket);
-            free(new_socket);
-            continue;
+        struct epoll_event ev;
+        // EPOLLOUT (edge-triggered) báo khi socket gửi được tiếp sau EAGAIN
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = client_fd;
+        if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            perror("epoll_ctl failed");
+            closeClient(reactor, client_fd);
         }
-        pthread_detach(thread_id);
     }
 }
 
-void* Server::handleClient(void* arg) {
-    int new_socket = *(int*)arg;
-    free(arg);
+const char* Server::peerName(const struct sockaddr_storage& address) {
+    if (address.ss_family == AF_INET) {
+        return inet_ntoa(((const struct sockaddr_in&)address).sin_addr);
+    }
+    if (address.ss_family == AF_UNIX) return config.unix_path.c_str();
+    return "unknown";
+}
 
-    fcntl(new_socket, F_SETFL, O_NONBLOCK);
+Server::Connection* Server::addConnection(Reactor& reactor, int client_fd, const char* peer) {
+    Connection* slot = reactor.connections.acquire();
+    if (!slot) {
+        reactor.stats->add(STAT_REJECTED);
+        LOG_INFO("Connection pool of reactor %d is full (%zu), rejecting client %s", reactor.index,
+                 reactor.connections.capacity(), peer);
+        close(client_fd);
+        return NULL;
+    }
+    if ((size_t)client_fd >= reactor.by_fd.size()) reactor.by_fd.resize(client_fd + FD_TABLE_SLACK, NULL);
+    reactor.by_fd[client_fd] = slot;
+
+    Connection& conn = *slot;
+    conn.fd = client_fd;
+    conn.peer = peer;
+    // Buffer được cấp sẵn cùng slab; clear() giữ nguyên capacity nên kết nối mới
+    // và các response sau không cấp phát thêm
+    conn.in.clear();
+    conn.out.clear();
+    conn.inflight.clear();
+    conn.inflight_off = 0;
+    conn.inflight_head = 0;
+    conn.closing = false;
+    conn.read_paused = false;
+    conn.evicted = false;
+    conn.binary = false;
+    conn.gorilla_block = 0;
+    conn.gorilla_frame = NULL;
+    conn.subscribed = false;
+    conn.range_active = false;
+    conn.push_period_ns = 0;
+    conn.next_push_ns = 0;
+    conn.aggregate = NULL;
+    conn.aggregate_sent = -1;
+    conn.last_activity_ns = nowNs();
+    conn.push_timer.user_data = ((uint64_t)TIMER_PUSH << 32) | (uint32_t)client_fd;
+    conn.idle_timer.user_data = ((uint64_t)TIMER_IDLE << 32) | (uint32_t)client_fd;
+    if (config.idle_timeout_s > 0) {
+        reactor.timers.schedule(&conn.idle_timer, conn.last_activity_ns + config.idle_timeout_s * 1000000000LL);
+        armTimer(reactor);
+    }
+    conn.samples_sent = 0;
+    conn.hot_path_allocations = 0;
+    conn.frame_head = 0;
+    conn.frame_count = 0;
+    conn.frame_offset = 0;
+    conn.policy = config.slow_consumer_policy;
+    conn.frames_dropped = 0;
+    conn.queue_high_water = 0;
+    conn.out_high_water = 0;
+    conn.stats = reactor.stats.get();
+    conn.request_start_ns = 0;
+    conn.send_inflight = false;
+    conn.frames_inflight = 0;
+    memset(&conn.msg, 0, sizeof(conn.msg));
+    reactor.stats->add(STAT_ACCEPTED);
+    reactor.stats->add(STAT_CONNECTIONS);
+
+    LOG_INFO("New client connected from %s (reactor %d)", conn.peer.c_str(), reactor.index);
+    return slot;
+}
+
+void Server::releaseConnection(Reactor& reactor, Connection& conn) {
+    logDisconnect(conn);
+    cancelTimers(reactor, conn);
+    releaseFrames(conn);
+    releaseAggregate(conn);
+    reactor.by_fd[conn.fd] = NULL;
+    reactor.stats->sub(STAT_CONNECTIONS, 1);
+    close(conn.fd);
+    conn.fd = -1;
+    reactor.connections.release(&conn);
+}
+
+void Server::closeClient(Reactor& reactor, int client_fd) {
+    // fd không còn trong bảng nghĩa là đã đóng (có thể đã được cấp lại cho kết nối khác)
+    Connection* conn = findConnection(reactor, client_fd);
+    if (!conn) return;
+
+    epoll_ctl(reactor.epoll_fd, EPOLL_CTL_DEL, client_fd, NULL);
+    releaseConnection(reactor, *conn);
+}
 
+void Server::cancelTimers(Reactor& reactor, Connection& conn) {
+    reactor.timers.cancel(&conn.push_timer);
+    reactor.timers.cancel(&conn.idle_timer);
+}
+
+void Server::logDisconnect(const Connection& conn) {
+    LOG_INFO("Client %s disconnected: %llu samples sent, %llu heap allocations on the request path, "
+             "%llu frames dropped, output high-water %u frames / %zu bytes",
+             conn.peer.c_str(), (unsigned long long)conn.samples_sent,
+             (unsigned long long)conn.hot_path_allocations, (unsigned long long)conn.frames_dropped,
+             conn.queue_high_water, conn.out_high_water);
+}
+
+bool Server::handleClient(Reactor& reactor, int client_fd) {
+    // Kết nối có thể đã bị đóng bởi sự kiện trước đó trong cùng lượt epoll_wait
+    Connection* found = findConnection(reactor, client_fd);
+    if (!found) return true;
+    Connection& conn = *found;
+    bool was_subscribed = conn.subscribed;
+    int64_t next_push = conn.next_push_ns;
     char buffer[1024] = {0};
+    // Edge-triggered: đọc cho đến khi hết dữ liệu (EAGAIN)
     while (true) {
-        int valread = read(new_socket, buffer, 1024);
+        // Backpressure: client gửi request nhưng không đọc response thì ngừng đọc,
+        // EPOLLOUT sẽ tiếp tục khi response đã gửi bớt
+        if (conn.out.size() >= MAX_OUT_BYTES) {
+            sendPending(conn);
+            if (conn.out.size() >= MAX_OUT_BYTES) {
+                conn.read_paused = true;
+                break;
+            }
+        }
+
+        int valread = read(client_fd, buffer, 1024);
         if (valread <= 0) {
-            if (valread < 0 && errno == EAGAIN) {
-                std::this_thread::sleep_for(std::chrono::microseconds(100));
-                continue;
+            if (valread < 0 && errno == EINTR) continue;
+            if (valread < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            return false;
+        }
+        reactor.stats->add(STAT_BYTES_IN, valread);
+
+        uint64_t allocations = threadAllocations();
+        handleRequest(reactor, conn, buffer, valread);
+        conn.hot_path_allocations += threadAllocations() - allocations;
+    }
+
+    // Response của mọi lệnh đọc được trong lượt này được gửi bằng một sendmsg
+    uint64_t allocations = threadAllocations();
+    sendPending(conn);
+    conn.hot_path_allocations += threadAllocations() - allocations;
+
+    if (conn.subscribed != was_subscribed || conn.next_push_ns != next_push) armTimer(reactor);
+    return true;
+}
+
+bool Server::handleWritable(Reactor& reactor, int client_fd) {
+    Connection* found = findConnection(reactor, client_fd);
+    if (!found) return true;
+    Connection& conn = *found;
+
+    sendPending(conn);
+    // Edge-triggered: request còn nằm trong socket sẽ không báo EPOLLIN lần nữa
+    if (conn.read_paused && conn.out.size() < MAX_OUT_BYTES) {
+        conn.read_paused = false;
+        return handleClient(reactor, client_fd);
+    }
+    return true;
+}
+
+void Server::sendPending(Connection& conn) {
+    while (true) {
+        if (conn.range_active) fillRange(conn);
+
+        // Response của lệnh đi trước, sau đó là các frame push; tất cả trong một sendmsg.
+        // Frame đầu hàng đợi đã gửi dở thì phải gửi nốt trước khi chen response vào luồng.
+        size_t head_len = conn.frame_offset > 0 ? 0 : conn.out.size();
+        int iovcnt = gatherOutput(conn, conn.out.data(), head_len);
+        if (iovcnt == 0) return;
+
+        conn.msg.msg_iov = conn.iov;
+        conn.msg.msg_iovlen = iovcnt;
+        ssize_t sent = sendmsg(conn.fd, &conn.msg, MSG_NOSIGNAL);
+        conn.frames_inflight = 0;
+        conn.stats->add(STAT_SENDS);
+        if (sent < 0) {
+            conn.stats->add(errno == EAGAIN || errno == EWOULDBLOCK ? STAT_SEND_EAGAIN : STAT_SEND_ERRORS);
+        }
+        if (sent <= 0) return;      // EAGAIN: giữ lại, gửi tiếp ở lần sau
+        conn.last_activity_ns = nowNs();
+        conn.stats->add(STAT_BYTES_OUT, sent);
+
+        size_t from_out = (size_t)sent < head_len ? (size_t)sent : head_len;
+        conn.out.erase(0, from_out);
+        consumeFrames(conn, sent - from_out);
+        if (conn.out.empty()) responseSent(conn);
+
+        // Edge-triggered: gửi hết mà còn lịch sử thì nạp tiếp ngay, không có EPOLLOUT nào nữa
+        if (!conn.range_active || !conn.out.empty()) return;
+    }
+}
+
+void Server::fillRange(Connection& conn) {
+    SampleFrame frames[RANGE_BATCH];
+    while (conn.range_active && conn.out.size() < RANGE_CHUNK_BYTES) {
+        uint64_t index = conn.range_next;
+        size_t count = 0;
+        if (index < conn.range_end) {
+            count = conn.range_end - index < RANGE_BATCH ? conn.range_end - index : RANGE_BATCH;
+            count = history->read(index, frames, count);
+            // Mẫu đầu đoạn đã bị ghi đè: read() dời index lên, không vượt quá cuối đoạn
+            if (index >= conn.range_end) {
+                index = conn.range_end;
+                count = 0;
+            } else if (count > conn.range_end - index) {
+                count = conn.range_end - index;
             }
-            break;
         }
+        conn.range_lost += index - conn.range_next;
+        conn.range_next = index + count;
+
+        size_t old_size = conn.out.size();
+        if (conn.gorilla_block && count > 0) {
+            // Tải lịch sử là trường hợp nén có lợi nhất: cả lô thành một khối
+            GorillaEncoder encoder;
+            conn.out.resize(old_size + GORILLA_BLOCK_MAX_SIZE);
+            encoder.begin(&conn.out[old_size]);
+            size_t added = 0;
+            while (added < count) {
+                frames[added].channel_mask &= conn.range_mask;
+                if (!encoder.add(frames[added])) break;
+                ++added;
+            }
+            conn.out.resize(old_size + encoder.finish());
+            conn.range_next -= count - added;
+            count = added;
+        } else {
+            conn.out.resize(old_size + count * SAMPLE_MAX_SIZE);
+            char* dst = &conn.out[old_size];
+            for (size_t i = 0; i < count; ++i) {
+                frames[i].channel_mask &= conn.range_mask;
+                dst += conn.binary ? encodeFrame(frames[i], dst) : encodeTextSample(frames[i], dst);
+            }
+            conn.out.resize(dst - conn.out.data());
+        }
+        conn.range_sent += count;
+
+        if (conn.range_next >= conn.range_end) {
+            char line[96];
+            int n = snprintf(line, sizeof(line), "END RANGE sent=%llu lost=%llu\n",
+                             (unsigned long long)conn.range_sent, (unsigned long long)conn.range_lost);
+            if (n > 0) conn.out.append(line, n);
+            conn.range_active = false;
+        }
+    }
+}
+
+SharedFrame* Server::sharedFrame(Reactor& reactor, const SampleFrame& sample, bool binary) {
+    SharedFrame*& cached = reactor.cached_frames[binary ? 1 : 0];
+    if (cached && cached->sequence == sample.sequence) return cached;
+
+    if (cached) cached->release();
+    cached = reactor.frame_pool.encode(sample, binary);
+    ++reactor.frames_encoded;
+    return cached;
+}
+
+SharedFrame* Server::aggregateFrame(Reactor& reactor, Connection& conn) {
+    AggregateFrame result;
+    if (!conn.aggregate->latest(result) || (int64_t)result.sequence == conn.aggregate_sent) return NULL;
+    conn.aggregate_sent = result.sequence;
+
+    // Như sharedFrame: mỗi kết quả encode một lần cho mỗi định dạng trong reactor
+    SharedFrame*& cached = reactor.aggregate_frames[conn.aggregate->id()][conn.binary ? 1 : 0];
+    if (cached && cached->sequence == result.sequence) return cached;
+
+    if (cached) cached->release();
+    cached = reactor.frame_pool.encodeAggregate(result, conn.binary);
+    ++reactor.frames_encoded;
+    return cached;
+}
+
+SharedFrame* Server::gorillaFrame(Reactor& reactor, Connection& conn, const SampleFrame& sample) {
+    // Trạng thái nén phụ thuộc các mẫu trước của chính kết nối nên khối không dùng chung
+    SharedFrame* block = NULL;
+    if (conn.gorilla_frame) {
+        if (conn.gorilla.add(sample)) {
+            return conn.gorilla.count() >= conn.gorilla_block ? finishGorillaBlock(conn) : NULL;
+        }
+        block = finishGorillaBlock(conn);       // mask đổi hoặc đồng hồ nhảy: bắt đầu khối mới
+    }
+
+    conn.gorilla_frame = reactor.frame_pool.acquire();
+    conn.gorilla_frame->binary = true;
+    conn.gorilla_frame->sequence = sample.sequence;
+    conn.gorilla.begin(conn.gorilla_frame->data);
+    conn.gorilla.add(sample);
+    ++reactor.frames_encoded;
+    return block;
+}
+
+SharedFrame* Server::finishGorillaBlock(Connection& conn) {
+    SharedFrame* block = conn.gorilla_frame;
+    block->length = conn.gorilla.finish();
+    conn.gorilla_frame = NULL;
+    return block;
+}
+
+void Server::flushGorilla(Reactor& reactor, Connection& conn) {
+    // Gửi nốt khối dở khi dừng push hoặc đổi định dạng
+    if (!conn.gorilla_frame) return;
+    SharedFrame* block = finishGorillaBlock(conn);
+    queueFrame(reactor, conn, block);
+    block->release();
+}
+
+bool Server::queueFrame(Reactor& reactor, Connection& conn, SharedFrame* frame) {
+    unsigned dropped = 0;
+    if (conn.policy == POLICY_COALESCE) {
+        // Mẫu mới thay thế mọi mẫu chưa kịp gửi
+        dropped = dropQueuedFrames(conn, conn.frame_count);
+    }
+    else if (conn.frame_count == MAX_QUEUED_FRAMES) {
+        if (conn.policy == POLICY_DISCONNECT) return false;
+        dropped = dropQueuedFrames(conn, 1);
+        if (dropped == 0) {
+            // Mọi frame trong hàng đợi đang được gửi: bỏ frame mới
+            ++conn.frames_dropped;
+            ++reactor.frames_dropped;
+            reactor.stats->add(STAT_FRAMES_DROPPED);
+            return true;
+        }
+    }
+    conn.frames_dropped += dropped;
+    reactor.frames_dropped += dropped;
+    reactor.stats->add(STAT_FRAMES_DROPPED, dropped);
+
+    frame->retain();
+    conn.frames[(conn.frame_head + conn.frame_count) % MAX_QUEUED_FRAMES] = frame;
+    ++conn.frame_count;
+    reactor.stats->add(STAT_QUEUED_FRAMES);
+    if (conn.frame_count > conn.queue_high_water) {
+        conn.queue_high_water = conn.frame_count;
+        reactor.stats->raise(STAT_QUEUE_HIGH_WATER, conn.frame_count);
+    }
+    return true;
+}
+
+unsigned Server::dropQueuedFrames(Connection& conn, unsigned count) {
+    // Chỉ bỏ frame chưa bắt đầu gửi: frame đang gửi dở hoặc đang nằm trong SENDMSG được giữ lại
+    unsigned first = conn.frames_inflight;
+    if (first == 0 && conn.frame_offset > 0) first = 1;
+    if (first >= conn.frame_count) return 0;
+    if (count > conn.frame_count - first) count = conn.frame_count - first;
+
+    for (unsigned i = first; i < first + count; ++i) {
+        conn.frames[(conn.frame_head + i) % MAX_QUEUED_FRAMES]->release();
+    }
+    for (unsigned i = first; i + count < conn.frame_count; ++i) {
+        conn.frames[(conn.frame_head + i) % MAX_QUEUED_FRAMES] =
+            conn.frames[(conn.frame_head + i + count) % MAX_QUEUED_FRAMES];
+    }
+    conn.frame_count -= count;
+    conn.stats->sub(STAT_QUEUED_FRAMES, count);
+    return count;
+}
+
+int Server::gatherOutput(Connection& conn, const char* head, size_t head_len) {
+    int iovcnt = 0;
+    if (head_len > 0) {
+        conn.iov[iovcnt].iov_base = (void*)head;
+        conn.iov[iovcnt].iov_len = head_len;
+        ++iovcnt;
+    }
+
+    conn.frames_inflight = 0;
+    for (unsigned i = 0; i < conn.frame_count && iovcnt < MAX_IOV; ++i) {
+        SharedFrame* frame = conn.frames[(conn.frame_head + i) % MAX_QUEUED_FRAMES];
+        size_t offset = i == 0 ? conn.frame_offset : 0;
+        conn.iov[iovcnt].iov_base = frame->data + offset;
+        conn.iov[iovcnt].iov_len = frame->length - offset;
+        ++iovcnt;
+        ++conn.frames_inflight;
+    }
+    return iovcnt;
+}
+
+void Server::consumeFrames(Connection& conn, size_t bytes) {
+    while (bytes > 0 && conn.frame_count > 0) {
+        SharedFrame* frame = conn.frames[conn.frame_head];
+        size_t remaining = frame->length - conn.frame_offset;
+        if (bytes < remaining) {
+            conn.frame_offset += bytes;
+            return;
+        }
+        bytes -= remaining;
+        frame->release();
+        conn.frame_head = (conn.frame_head + 1) % MAX_QUEUED_FRAMES;
+        --conn.frame_count;
+        conn.stats->sub(STAT_QUEUED_FRAMES, 1);
+        conn.frame_offset = 0;
+    }
+}
+
+void Server::releaseFrames(Connection& conn) {
+    if (conn.gorilla_frame) {
+        conn.gorilla.finish();
+        conn.gorilla_frame->release();
+        conn.gorilla_frame = NULL;
+    }
+    conn.stats->sub(STAT_QUEUED_FRAMES, conn.frame_count);
+    while (conn.frame_count > 0) {
+        conn.frames[conn.frame_head]->release();
+        conn.frame_head = (conn.frame_head + 1) % MAX_QUEUED_FRAMES;
+        --conn.frame_count;
+    }
+    conn.frame_offset = 0;
+    conn.frames_inflight = 0;
+}
+
+void Server::appendSample(Reactor& reactor, Connection& conn) {
+    SampleFrame frame;
+    sampler.latest(frame);
+
+    // Encode thẳng vào buffer gửi của kết nối (đã reserve) thay vì nối các std::string tạm
+    size_t old_size = conn.out.size();
+    conn.out.resize(old_size + SAMPLE_MAX_SIZE);
+    char* dst = &conn.out[old_size];
+    size_t written = conn.binary ? encodeFrame(frame, dst) : encodeTextSample(frame, dst);
+    conn.out.resize(old_size + written);
+    ++conn.samples_sent;
+    ++reactor.samples_sent;
+
+    if (Logger::instance().enabled(DEBUG)) {
+        char text[TEXT_SAMPLE_MAX_SIZE + 1];
+        size_t n = encodeTextSample(frame, text);
+        for (size_t i = 0; i < n; ++i) {
+            if (text[i] == '\n') text[i] = ' ';
+        }
+        LOG_DEBUG("Sent %.*s to %s", (int)n, text, conn.peer.c_str());
+    }
+}
+
+void Server::logSummary(Reactor& reactor) {
+    if (!Logger::instance().enabled(INFO) || reactor.samples_sent == 0) return;
+
+    int64_t now = nowNs();
+    if (now < reactor.next_summary_ns) return;
+    if (reactor.next_summary_ns != 0) {
+        LOG_INFO("Reactor %d: %llu samples sent to %zu client(s) in the last second, %llu frames encoded, "
+                 "%llu dropped", reactor.index, (unsigned long long)reactor.samples_sent,
+                 reactor.connections.size(), (unsigned long long)reactor.frames_encoded,
+                 (unsigned long long)reactor.frames_dropped);
+        reactor.samples_sent = 0;
+        reactor.frames_encoded = 0;
+        reactor.frames_dropped = 0;
+    }
+    reactor.next_summary_ns = now + 1000000000;
+}
+
+static const struct {
+    const char* name;
+    SlowConsumerPolicy policy;
+} POLICY_NAMES[] = {
+    { "DROP_OLDEST", POLICY_DROP_OLDEST },
+    { "COALESCE", POLICY_COALESCE },
+    { "DISCONNECT", POLICY_DISCONNECT },
+};
+
+bool parseSlowConsumerPolicy(const char* name, size_t len, SlowConsumerPolicy& policy) {
+    for (size_t i = 0; i < sizeof(POLICY_NAMES) / sizeof(POLICY_NAMES[0]); ++i) {
+        if (len == strlen(POLICY_NAMES[i].name) && strncasecmp(name, POLICY_NAMES[i].name, len) == 0) {
+            policy = POLICY_NAMES[i].policy;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* slowConsumerPolicyName(SlowConsumerPolicy policy) {
+    for (size_t i = 0; i < sizeof(POLICY_NAMES) / sizeof(POLICY_NAMES[0]); ++i) {
+        if (POLICY_NAMES[i].policy == policy) return POLICY_NAMES[i].name;
+    }
+    return "UNKNOWN";
+}
+
+// So khớp tham số (không kết thúc '\0') với một từ khóa
+static bool argEquals(const char* args, size_t len, const char* word) {
+    size_t word_len = strlen(word);
+    return len == word_len && memcmp(args, word, word_len) == 0;
+}
+
+const Server::Command Server::COMMANDS[] = {
+    { "GET_DATA", &Server::cmdGetData },
+    { "SUBSCRIBE", &Server::cmdSubscribe },
+    { "AGGREGATE", &Server::cmdAggregate },
+    { "GET_RANGE", &Server::cmdGetRange },
+    { "UNSUBSCRIBE", &Server::cmdUnsubscribe },
+    { "PROTOCOL", &Server::cmdProtocol },
+    { "POLICY", &Server::cmdPolicy },
+    { "STATS", &Server::cmdStats },
+};
 
-        std::string request(buffer, valread);
+void Server::handleRequest(Reactor& reactor, Connection& conn, const char* data, size_t len) {
+    int64_t now = nowNs();
+    conn.last_activity_ns = now;
 
-        if (request.find("GET_DATA") != std::string::npos) {
-            double azimuth = azimuth_dist(rng);
-            double elevation = elevation_dist(rng);
-            double temperature = temp_dist(rng);
-            double humidity = humidity_dist(rng);
+    // Không có phần dư từ lần trước: tách dòng thẳng trên buffer vừa đọc, chỉ giữ lại
+    // phần cuối chưa có '\n'; ngược lại nối vào conn.in (đã reserve) rồi tách
+    const char* buffer = data;
+    size_t size = len;
+    if (!conn.in.empty()) {
+        conn.in.append(data, len);
+        buffer = conn.in.data();
+        size = conn.in.size();
+    }
 
-            std::string data = "AZ:" + std::to_string(azimuth) + "\n" +
-                               "EL:" + std::to_string(elevation) + "\n" +
-                               "TE:" + std::to_string(temperature) + "\n" +
-                               "HU:" + std::to_string(humidity) + "\n";
+    size_t pos = 0;
+    while (pos < size) {
+        const char* end = (const char*)memchr(buffer + pos, '\n', size - pos);
+        if (!end) break;
+        size_t line_len = end - (buffer + pos);
+        if (line_len > 0 && buffer[pos + line_len - 1] == '\r') --line_len;
+        if (line_len > 0) handleCommand(reactor, conn, buffer + pos, line_len);
+        pos = end - buffer + 1;
+    }
 
-            send(new_socket, data.c_str(), data.length(), 0);
-            std::cout << "Sent AZ: " << azimuth << std::endl;
-            std::cout << "Sent EL: " << elevation << std::endl;
-            std::cout << "Sent TE: " << temperature << std::endl;
-            std::cout << "Sent HU: " << humidity << std::endl;
+    size_t rest = size - pos;
+    if (rest > MAX_LINE_LENGTH) {
+        conn.out += "ERR line too long\n";
+        rest = 0;
+    }
+    if (buffer == data) conn.in.assign(data + pos, rest);
+    else conn.in.erase(0, size - rest);
+
+    if (conn.out.size() > conn.out_high_water) conn.out_high_water = conn.out.size();
+    // Response đầu tiên chưa gửi được tính độ trễ từ lần đọc này
+    if (!conn.out.empty() && conn.request_start_ns == 0) conn.request_start_ns = now;
+}
+
+void Server::responseSent(Connection& conn) {
+    if (conn.request_start_ns == 0) return;
+    conn.stats->latency.record(nowNs() - conn.request_start_ns);
+    conn.request_start_ns = 0;
+}
+
+void Server::handleCommand(Reactor& reactor, Connection& conn, const char* line, size_t len) {
+    const char* space = (const char*)memchr(line, ' ', len);
+    size_t name_len = space ? space - line : len;
+    const char* args = line + name_len;
+    size_t args_len = len - name_len;
+    while (args_len > 0 && *args == ' ') {
+        ++args;
+        --args_len;
+    }
+
+    reactor.stats->add(STAT_REQUESTS);
+    for (size_t i = 0; i < sizeof(COMMANDS) / sizeof(COMMANDS[0]); ++i) {
+        if (strlen(COMMANDS[i].name) == name_len && memcmp(COMMANDS[i].name, line, name_len) == 0) {
+            (this->*COMMANDS[i].handler)(reactor, conn, args, args_len);
+            return;
         }
     }
-    close(new_socket);
+    conn.out += "ERR unknown command\n";
+}
+
+void Server::cmdGetData(Reactor& reactor, Connection& conn, const char*, size_t) {
+    appendSample(reactor, conn);
+}
+
+void Server::cmdSubscribe(Reactor& reactor, Connection& conn, const char* args, size_t len) {
+    // args không kết thúc bằng '\0': copy ra buffer nhỏ trên stack cho strtod
+    char arg[32];
+    if (len > sizeof(arg) - 1) len = sizeof(arg) - 1;
+    memcpy(arg, args, len);
+    arg[len] = '\0';
+
+    char* end;
+    double rate_hz = strtod(arg, &end);
+    while (*end == ' ') ++end;
+    // Viết dạng phủ định để NaN cũng bị từ chối
+    if (end == arg || *end != '\0' || !(rate_hz >= MIN_SUBSCRIBE_HZ && rate_hz <= MAX_SUBSCRIBE_HZ)) {
+        char line[64];
+        int n = snprintf(line, sizeof(line), "ERR SUBSCRIBE rate must be in [%g, %d] Hz\n", MIN_SUBSCRIBE_HZ,
+                         MAX_SUBSCRIBE_HZ);
+        if (n > 0) conn.out.append(line, n);
+        return;
+    }
+    conn.subscribed = true;
+    releaseAggregate(conn);
+    conn.push_period_ns = (int64_t)(1e9 / rate_hz);
+    conn.next_push_ns = nowNs() + conn.push_period_ns;
+    reactor.timers.schedule(&conn.push_timer, conn.next_push_ns);
+    char rate[FIXED_MAX_SIZE];
+    conn.out += "OK SUBSCRIBE ";
+    conn.out.append(rate, formatFixed(rate_hz, rate));
+    conn.out += '\n';
+    LOG_INFO("Client %s subscribed at %f Hz", conn.peer.c_str(), rate_hz);
+}
+
+void Server::cmdAggregate(Reactor& reactor, Connection& conn, const char* args, size_t len) {
+    char arg[32];
+    if (len > sizeof(arg) - 1) len = sizeof(arg) - 1;
+    memcpy(arg, args, len);
+    arg[len] = '\0';
+
+    // "AGGREGATE <window> [stride]": stride mặc định bằng window (cửa sổ không chồng nhau)
+    char* end;
+    unsigned long window = strtoul(arg, &end, 10);
+    char* stride_arg = end;
+    unsigned long stride = strtoul(stride_arg, &end, 10);
+    if (end == stride_arg) stride = window;
+    while (*end == ' ') ++end;
+    if (*end != '\0') window = 0;
+    WindowAggregate* aggregate = window <= AggregatorSet::MAX_WINDOW && stride <= AggregatorSet::MAX_WINDOW
+                                     ? aggregates.acquire((unsigned)window, (unsigned)stride) : NULL;
+    if (!aggregate) {
+        if (window == 0 || stride == 0 || window > AggregatorSet::MAX_WINDOW || stride > AggregatorSet::MAX_WINDOW) {
+            char line[64];
+            int n = snprintf(line, sizeof(line), "ERR AGGREGATE window and stride must be in [1, %u] samples\n",
+                             (unsigned)AggregatorSet::MAX_WINDOW);
+            if (n > 0) conn.out.append(line, n);
+        } else {
+            conn.out += "ERR AGGREGATE too many distinct windows\n";
+        }
+        return;
+    }
+
+    flushGorilla(reactor, conn);
+    // Reference mới được lấy trước khi trả cái cũ: AGGREGATE lặp lại cùng cặp không làm
+    // mất cửa sổ đang tính. Kết quả được đẩy theo stride của mẫu (pushAggregates), nên
+    // không phụ thuộc tần số lấy mẫu danh nghĩa (replay "max", thiết bị thật)
+    releaseAggregate(conn);
+    reactor.timers.cancel(&conn.push_timer);
+    conn.subscribed = true;
+    conn.aggregate = aggregate;
+    conn.aggregate_sent = -1;
+
+    char line[64];
+    int n = snprintf(line, sizeof(line), "OK AGGREGATE %lu %lu\n", window, stride);
+    if (n > 0) conn.out.append(line, n);
+    LOG_INFO("Client %s aggregating window=%lu stride=%lu (%d active aggregates)", conn.peer.c_str(),
+             window, stride, aggregates.active());
+}
+
+void Server::cmdGetRange(Reactor&, Connection& conn, const char* args, size_t len) {
+    if (!history) {
+        conn.out += "ERR GET_RANGE history is disabled\n";
+        return;
+    }
+    if (conn.range_active) {
+        conn.out += "ERR GET_RANGE previous range still in progress\n";
+        return;
+    }
+
+    // "GET_RANGE <from_us> <to_us> [tag,tag,...]" (tag theo schema kênh, ví dụ AZ,EL): timestamp micro giây như trong frame
+    char arg[48 + 3 * CH_COUNT];
+    if (len > sizeof(arg) - 1) len = sizeof(arg) - 1;
+    memcpy(arg, args, len);
+    arg[len] = '\0';
+
+    char* end;
+    unsigned long long from_us = strtoull(arg, &end, 10);
+    char* to_arg = end;
+    unsigned long long to_us = strtoull(to_arg, &end, 10);
+    bool valid = end != to_arg && end != arg && from_us <= to_us;
+
+    ChannelMask mask = CHANNEL_MASK_ALL;
+    while (*end == ' ') ++end;
+    if (valid && *end != '\0') {
+        // Danh sách kênh cách nhau bởi dấu phẩy
+        mask = 0;
+        char* save;
+        for (char* tag = strtok_r(end, ", ", &save); tag && valid; tag = strtok_r(NULL, ", ", &save)) {
+            int ch = strlen(tag) == 2 ? channelFromTag(tag[0], tag[1]) : -1;
+            if (ch < 0) valid = false;
+            else mask |= channelBit(ch);
+        }
+    }
+    if (!valid) {
+        conn.out += "ERR GET_RANGE usage: GET_RANGE <from_us> <to_us> [tag,tag,...]\n";
+        return;
+    }
+
+    uint64_t first, last;
+    history->find(from_us, to_us, first, last);
+    conn.range_active = true;
+    conn.range_next = first;
+    conn.range_end = last;
+    conn.range_mask = mask;
+    conn.range_sent = 0;
+    conn.range_lost = 0;
+
+    char line[64];
+    int n = snprintf(line, sizeof(line), "OK RANGE %llu\n", (unsigned long long)(last - first));
+    if (n > 0) conn.out.append(line, n);
+    fillRange(conn);
+}
+
+void Server::cmdUnsubscribe(Reactor& reactor, Connection& conn, const char*, size_t) {
+    flushGorilla(reactor, conn);
+    conn.subscribed = false;
+    releaseAggregate(conn);
+    reactor.timers.cancel(&conn.push_timer);
+    conn.out += "OK UNSUBSCRIBE\n";
+}
+
+void Server::cmdProtocol(Reactor& reactor, Connection& conn, const char* args, size_t len) {
+    if (argEquals(args, len, "BINARY")) {
+        flushGorilla(reactor, conn);
+        conn.binary = true;
+        conn.gorilla_block = 0;
+        conn.out += "OK PROTOCOL BINARY\n";
+    }
+    else if (argEquals(args, len, "TEXT")) {
+        flushGorilla(reactor, conn);
+        conn.binary = false;
+        conn.gorilla_block = 0;
+        conn.out += "OK PROTOCOL TEXT\n";
+    }
+    else if (len >= 7 && memcmp(args, "GORILLA", 7) == 0 && (len == 7 || args[7] == ' ')) {
+        // "GORILLA [n]": khối n mẫu, khối lớn nén tốt hơn nhưng trễ thêm n chu kỳ push
+        char arg[32];
+        size_t arg_len = len - 7 < sizeof(arg) - 1 ? len - 7 : sizeof(arg) - 1;
+        memcpy(arg, args + 7, arg_len);
+        arg[arg_len] = '\0';
+        char* end;
+        unsigned long block = strtoul(arg, &end, 10);
+        if (end == arg) block = GORILLA_DEFAULT_BLOCK_SAMPLES;
+        while (*end == ' ') ++end;
+        if (*end != '\0' || block < 2 || block > GORILLA_MAX_BLOCK_SAMPLES) {
+            char line[64];
+            int n = snprintf(line, sizeof(line), "ERR PROTOCOL GORILLA block must be in [2, %u] samples\n",
+                             (unsigned)GORILLA_MAX_BLOCK_SAMPLES);
+            if (n > 0) conn.out.append(line, n);
+            return;
+        }
+        flushGorilla(reactor, conn);
+        // Response của GET_DATA và AGGREGATE dùng frame nhị phân thường
+        conn.binary = true;
+        conn.gorilla_block = (unsigned)block;
+        char line[64];
+        int n = snprintf(line, sizeof(line), "OK PROTOCOL GORILLA %lu\n", block);
+        if (n > 0) conn.out.append(line, n);
+    }
+    else {
+        conn.out += "ERR PROTOCOL must be BINARY, TEXT or GORILLA [block]\n";
+    }
+}
+
+void Server::cmdPolicy(Reactor&, Connection& conn, const char* args, size_t len) {
+    if (parseSlowConsumerPolicy(args, len, conn.policy)) {
+        conn.out += "OK POLICY ";
+        conn.out += slowConsumerPolicyName(conn.policy);
+        conn.out += '\n';
+        return;
+    }
+    conn.out += "ERR POLICY must be DROP_OLDEST, COALESCE or DISCONNECT\n";
+}
+
+void Server::cmdStats(Reactor&, Connection& conn, const char* args, size_t len) {
+    // snprintf vào buffer trên stack: không cấp phát trên đường request
+    char line[512];
+    int n;
+    if (argEquals(args, len, "SERVER")) {
+        // Tổng hợp mọi reactor tại lúc đọc; reactor khác vẫn ghi tiếp, không bị chặn
+        StatsSnapshot snapshot;
+        snapshotStats(snapshot);
+        n = snprintf(line, sizeof(line), "STATS SERVER reactors=%zu ", reactors.size());
+        n += snapshot.formatCounters(line + n, sizeof(line) - n - 1);
+        line[n++] = '\n';
+        conn.out.append(line, n);
+        n = snprintf(line, sizeof(line), "STATS LATENCY ");
+        n += snapshot.latency.format(line + n, sizeof(line) - n - 1);
+        line[n++] = '\n';
+        conn.out.append(line, n);
+        // Độ trễ thức dậy của thread lấy mẫu so với lịch
+        LatencySnapshot jitter;
+        jitter.add(sampler.jitter());
+        n = snprintf(line, sizeof(line), "STATS JITTER ");
+        n += jitter.format(line + n, sizeof(line) - n - 1);
+        line[n++] = '\n';
+        conn.out.append(line, n);
+        return;
+    }
+    if (len > 0) {
+        conn.out += "ERR STATS usage: STATS [SERVER]\n";
+        return;
+    }
+    n = snprintf(line, sizeof(line),
+                 "STATS samples_sent=%llu frames_dropped=%llu frames_queued=%u queue_high_water=%u "
+                 "out_high_water=%zu allocations=%llu\n",
+                 (unsigned long long)conn.samples_sent, (unsigned long long)conn.frames_dropped,
+                 conn.frame_count, conn.queue_high_water, conn.out_high_water,
+                 (unsigned long long)conn.hot_path_allocations);
+    if (n > 0) conn.out.append(line, (size_t)n < sizeof(line) ? n : sizeof(line) - 1);
+}
+
+void Server::snapshotStats(StatsSnapshot& snapshot) const {
+    for (size_t i = 0; i < reactors.size(); ++i) snapshot.add(*reactors[i].stats);
+}
+
+void* Server::statsThread(void* arg) {
+    static_cast<Server*>(arg)->runStatsDump();
     return NULL;
 }
+
+void Server::runStatsDump() {
+    // Ngủ theo bước ngắn để destructor không phải chờ hết một chu kỳ
+    const int64_t interval_ns = config.stats_interval_s * 1000000000LL;
+    int64_t next_dump = nowNs() + interval_ns;
+    while (stats_running.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        int64_t now = nowNs();
+        if (now < next_dump) continue;
+        next_dump = now + interval_ns;
+
+        StatsSnapshot snapshot;
+        snapshotStats(snapshot);
+        LatencySnapshot jitter;
+        jitter.add(sampler.jitter());
+        char counters[384];
+        char latency[160];
+        char wakeup[160];
+        snapshot.formatCounters(counters, sizeof(counters));
+        snapshot.latency.format(latency, sizeof(latency));
+        jitter.format(wakeup, sizeof(wakeup));
+        LOG_INFO("Stats: %s", counters);
+        LOG_INFO("Stats latency: %s", latency);
+        LOG_INFO("Stats sampling jitter: %s", wakeup);
+    }
+}
+
+int64_t Server::nowNs() {
+    // steady_clock trên Linux là CLOCK_MONOTONIC, cùng clock với timerfd
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Server::runTimers(Reactor& reactor) {
+    int64_t now = nowNs();
+    reactor.ready.clear();
+    reactor.expired.clear();
+    reactor.timers.advance(now, reactor.expired);
+
+    SampleFrame sample;
+    bool have_sample = false;
+    size_t pushed = 0;
+
+    for (size_t i = 0; i < reactor.expired.size(); ++i) {
+        TimerNode* node = reactor.expired[i];
+        Connection* found = findConnection(reactor, (int)(uint32_t)node->user_data);
+        if (!found) continue;
+        Connection& conn = *found;
+        if (conn.evicted || conn.closing) continue;
+
+        if ((node->user_data >> 32) == TIMER_IDLE) {
+            // last_activity_ns được cập nhật mà không hẹn lại timer: kiểm tra khi tới hạn
+            int64_t deadline = conn.last_activity_ns + config.idle_timeout_s * 1000000000LL;
+            if (deadline > now) {
+                reactor.timers.schedule(&conn.idle_timer, deadline);
+                continue;
+            }
+            LOG_INFO("Client %s idle for %d s, disconnecting", conn.peer.c_str(), config.idle_timeout_s);
+            conn.evicted = true;
+            conn.subscribed = false;
+            cancelTimers(reactor, conn);
+            reactor.ready.push_back(conn.fd);
+            continue;
+        }
+
+        if (!conn.subscribed || conn.aggregate) continue;
+
+        // Frame được encode một lần cho mỗi mẫu, các subscriber chỉ giữ reference
+        if (!have_sample) {
+            sampler.latest(sample);
+            have_sample = true;
+        }
+        bool owned = conn.gorilla_block != 0;
+        SharedFrame* frame = owned ? gorillaFrame(reactor, conn, sample)
+                                   : sharedFrame(reactor, sample, conn.binary);
+        if (!pushFrame(reactor, conn, frame, owned)) continue;
+        if (frame) ++pushed;
+
+        // Giữ lịch cố định; nếu bị trễ quá một chu kỳ thì bỏ qua các mẫu đã lỡ
+        conn.next_push_ns += conn.push_period_ns;
+        if (conn.next_push_ns <= now) conn.next_push_ns = now + conn.push_period_ns;
+        reactor.timers.schedule(&conn.push_timer, conn.next_push_ns);
+    }
+
+    if (pushed > 0 && have_sample) {
+        LOG_DEBUG("Pushed sample %u to %zu subscriber(s)", sample.sequence, pushed);
+    }
+    armTimer(reactor);
+}
+
+bool Server::pushFrame(Reactor& reactor, Connection& conn, SharedFrame* frame, bool owned) {
+    uint64_t allocations = threadAllocations();
+    bool queued = !frame || queueFrame(reactor, conn, frame);
+    if (frame && owned) frame->release();
+    conn.hot_path_allocations += threadAllocations() - allocations;
+    if (!queued) {
+        LOG_INFO("Client %s cannot keep up (%u frames queued), disconnecting",
+                 conn.peer.c_str(), conn.frame_count);
+        conn.evicted = true;
+        conn.subscribed = false;
+        cancelTimers(reactor, conn);
+        reactor.ready.push_back(conn.fd);
+        return false;
+    }
+    if (frame) {
+        ++conn.samples_sent;
+        ++reactor.samples_sent;
+        reactor.ready.push_back(conn.fd);
+    }
+    return true;
+}
+
+void Server::pushAggregates(Reactor& reactor) {
+    reactor.ready.clear();
+    // Slab liên tục: duyệt các slot đã dùng rẻ hơn giữ danh sách subscriber riêng
+    for (size_t i = 0; i < reactor.connections.highWater(); ++i) {
+        Connection& conn = reactor.connections[i];
+        if (conn.fd < 0 || !conn.aggregate || !conn.subscribed || conn.evicted || conn.closing) continue;
+        // Kết quả đã gửi bị bỏ qua; nhiều stride xong trước khi reactor kịp chạy thì chỉ gửi kết quả mới nhất
+        pushFrame(reactor, conn, aggregateFrame(reactor, conn), false);
+    }
+}
+
+void Server::releaseAggregate(Connection& conn) {
+    if (!conn.aggregate) return;
+    aggregates.release(conn.aggregate);
+    conn.aggregate = NULL;
+}
+
+void Server::armTimer(Reactor& reactor) {
+    // Chỉ gọi timerfd_settime khi deadline gần nhất thay đổi; 0 tắt timer
+    int64_t deadline = reactor.timers.nextDeadline();
+    if (deadline == reactor.timer_deadline_ns) return;
+    reactor.timer_deadline_ns = deadline;
+
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = deadline / 1000000000;
+    spec.it_value.tv_nsec = deadline % 1000000000;
+    timerfd_settime(reactor.timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
@@ -0,0 +1,259 @@
+#include "Server.h"
+#include "IoUring.h"
+
+// Backend io_uring: multishot accept, multishot recv với provided buffer ring,
+// SENDMSG (response + frame push dùng chung) được gom lại và submit một lần cho mỗi vòng lặp.
+
+namespace {
+
+enum UringOp { OP_ACCEPT = 1, OP_RECV = 2, OP_SEND = 3, OP_TIMER = 4, OP_AGGREGATE = 5 };
+
+const unsigned RING_ENTRIES = 256;
+const unsigned BUFFER_COUNT = 256;     // phải là lũy thừa của 2
+const unsigned BUFFER_SIZE = 2048;
+const uint16_t BUFFER_GROUP = 0;
+
+inline uint64_t makeUserData(UringOp op, int fd) {
+    return ((uint64_t)op << 32) | (uint32_t)fd;
+}
+
+struct io_uring_sqe* nextSqe(IoUring& ring) {
+    struct io_uring_sqe* sqe = ring.getSqe();
+    while (!sqe) {
+        ring.submit();
+        sqe = ring.getSqe();
+    }
+    return sqe;
+}
+
+void prepAccept(IoUring& ring, int listen_fd) {
+    struct io_uring_sqe* sqe = nextSqe(ring);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->user_data = makeUserData(OP_ACCEPT, listen_fd);
+}
+
+void prepRecv(IoUring& ring, int fd) {
+    struct io_uring_sqe* sqe = nextSqe(ring);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = makeUserData(OP_RECV, fd);
+}
+
+void prepSendMsg(IoUring& ring, int fd, const struct msghdr* msg) {
+    struct io_uring_sqe* sqe = nextSqe(ring);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)msg;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = makeUserData(OP_SEND, fd);
+}
+
+// READ 8 byte của timerfd/eventfd, treo chờ đến khi fd có giá trị
+void prepCounterRead(IoUring& ring, UringOp op, int fd, uint64_t* value) {
+    struct io_uring_sqe* sqe = nextSqe(ring);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)value;
+    sqe->len = sizeof(*value);
+    sqe->user_data = makeUserData(op, fd);
+}
+
+} // namespace
+
+bool Server::runUringReactor(Reactor& reactor) {
+    // Multishot recv cần kernel >= 6.0
+    if (!IoUring::kernelAtLeast(6, 0)) {
+        LOG_INFO("io_uring: kernel too old, reactor %d falling back to epoll", reactor.index);
+        return false;
+    }
+
+    IoUring ring;
+    if (!ring.init(RING_ENTRIES) || !ring.setupBufferRing(BUFFER_GROUP, BUFFER_COUNT, BUFFER_SIZE)) {
+        LOG_INFO("io_uring not available (%s), reactor %d falling back to epoll", strerror(errno),
+                 reactor.index);
+        return false;
+    }
+
+    LOG_INFO("Reactor %d using io_uring backend", reactor.index);
+
+    // Gửi dữ liệu đang chờ nếu kết nối không có SENDMSG nào đang chạy. out được
+    // chuyển sang inflight để request mới có thể tiếp tục ghi vào out.
+    auto flush = [&](Connection& conn) {
+        if (conn.send_inflight) return;
+        if (conn.range_active) fillRange(conn);
+        if (conn.inflight_off == conn.inflight.size()) {
+            conn.inflight.clear();
+            conn.inflight_off = 0;
+            conn.inflight.swap(conn.out);
+        }
+        // Frame đầu hàng đợi đã gửi dở: gửi nốt trước phần response
+        conn.inflight_head = conn.frame_offset > 0 ? 0 : conn.inflight.size() - conn.inflight_off;
+        int iovcnt = gatherOutput(conn, conn.inflight.data() + conn.inflight_off, conn.inflight_head);
+        if (iovcnt == 0) return;
+        conn.msg.msg_iov = conn.iov;
+        conn.msg.msg_iovlen = iovcnt;
+        conn.send_inflight = true;
+        prepSendMsg(ring, conn.fd, &conn.msg);
+    };
+
+    // Chỉ đóng khi không còn SENDMSG nào giữ buffer của kết nối
+    auto finish = [&](int fd) {
+        Connection* conn = findConnection(reactor, fd);
+        if (!conn || conn->send_inflight) return;
+        releaseConnection(reactor, *conn);
+    };
+
+    // io_uring trả -EAGAIN ngay với fd O_NONBLOCK, nên timerfd và eventfd chuyển sang
+    // blocking để READ luôn treo chờ lần hết hạn / kết quả AGGREGATE tiếp theo
+    uint64_t expirations = 0;
+    uint64_t aggregate_results = 0;
+    int timer_flags = fcntl(reactor.timer_fd, F_GETFL);
+    int aggregate_flags = fcntl(reactor.aggregate_fd, F_GETFL);
+    fcntl(reactor.timer_fd, F_SETFL, timer_flags & ~O_NONBLOCK);
+    fcntl(reactor.aggregate_fd, F_SETFL, aggregate_flags & ~O_NONBLOCK);
+    prepCounterRead(ring, OP_TIMER, reactor.timer_fd, &expirations);
+    prepCounterRead(ring, OP_AGGREGATE, reactor.aggregate_fd, &aggregate_results);
+
+    prepAccept(ring, reactor.listen_fd);
+    if (reactor.unix_fd >= 0) prepAccept(ring, reactor.unix_fd);
+    bool accept_started = false;
+
+    while (true) {
+        // Một syscall: submit mọi SQE của vòng trước và chờ ít nhất một CQE
+        if (ring.submit(1) < 0 && errno != EINTR) {
+            // Logger được drain khi thoát (hủy đối tượng static)
+            LOG_INFO("io_uring_enter failed: %s", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+
+        struct io_uring_cqe* cqe;
+        while ((cqe = ring.peekCqe()) != NULL) {
+            UringOp op = (UringOp)(cqe->user_data >> 32);
+            int fd = (int)(uint32_t)cqe->user_data;
+            int res = cqe->res;
+            unsigned flags = cqe->flags;
+            ring.cqeSeen();
+
+            if (op == OP_ACCEPT) {
+                if (res >= 0) {
+                    accept_started = true;
+                    struct sockaddr_storage address;
+                    socklen_t addrlen = sizeof(address);
+                    const char* peer = "unknown";
+                    if (getpeername(res, (struct sockaddr*)&address, &addrlen) == 0) {
+                        peer = peerName(address);
+                    }
+                    if (addConnection(reactor, res, peer)) prepRecv(ring, res);
+                } else if (res == -EINVAL && !accept_started) {
+                    // Kernel không hỗ trợ multishot accept
+                    LOG_INFO("io_uring: multishot accept unsupported, reactor %d falling back to epoll",
+                             reactor.index);
+                    fcntl(reactor.timer_fd, F_SETFL, timer_flags);
+                    fcntl(reactor.aggregate_fd, F_SETFL, aggregate_flags);
+                    return false;
+                } else if (res != -EAGAIN && res != -EINTR && res != -ECONNABORTED) {
+                    LOG_INFO("io_uring accept failed: %s", strerror(-res));
+                }
+                if (!(flags & IORING_CQE_F_MORE)) prepAccept(ring, fd);
+            }
+            else if (op == OP_RECV) {
+                Connection* found = findConnection(reactor, fd);
+                if (res > 0 && (flags & IORING_CQE_F_BUFFER)) {
+                    uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+                    if (found && !found->closing) {
+                        Connection& conn = *found;
+                        bool was_subscribed = conn.subscribed;
+                        int64_t next_push = conn.next_push_ns;
+                        reactor.stats->add(STAT_BYTES_IN, res);
+                        uint64_t allocations = threadAllocations();
+                        handleRequest(reactor, conn, ring.buffer(bid), res);
+                        flush(conn);
+                        conn.hot_path_allocations += threadAllocations() - allocations;
+                        // Multishot recv không tạm dừng được: client không đọc response thì ngắt
+                        if (conn.out.size() > MAX_OUT_BYTES && !conn.evicted) {
+                            LOG_INFO("Client %s is not reading responses, disconnecting", conn.peer.c_str());
+                            conn.evicted = true;
+                            conn.subscribed = false;
+                            shutdown(fd, SHUT_RDWR);
+                        }
+                        if (conn.subscribed != was_subscribed || conn.next_push_ns != next_push) {
+                            armTimer(reactor);
+                        }
+                    }
+                    ring.recycleBuffer(bid);
+                    if (!(flags & IORING_CQE_F_MORE)) prepRecv(ring, fd);
+                } else if (res == -ENOBUFS) {
+                    prepRecv(ring, fd);
+                } else if (!(flags & IORING_CQE_F_MORE)) {
+                    // EOF hoặc lỗi: multishot recv đã kết thúc
+                    if (found) found->closing = true;
+                    finish(fd);
+                }
+            }
+            else if (op == OP_TIMER || op == OP_AGGREGATE) {
+                if (res < 0 && res != -EINTR) {
+                    LOG_INFO("io_uring %s read failed: %s", op == OP_TIMER ? "timer" : "aggregate event",
+                             strerror(-res));
+                }
+                if (op == OP_TIMER) runTimers(reactor);
+                else pushAggregates(reactor);
+                for (size_t i = 0; i < reactor.ready.size(); ++i) {
+                    Connection* conn = findConnection(reactor, reactor.ready[i]);
+                    if (!conn) continue;
+                    // Kết thúc multishot recv, CQE cuối của nó sẽ đóng kết nối
+                    if (conn->evicted) shutdown(conn->fd, SHUT_RDWR);
+                    else flush(*conn);
+                }
+                if (op == OP_TIMER) prepCounterRead(ring, OP_TIMER, reactor.timer_fd, &expirations);
+                else prepCounterRead(ring, OP_AGGREGATE, reactor.aggregate_fd, &aggregate_results);
+            }
+            else if (op == OP_SEND) {
+                Connection* found = findConnection(reactor, fd);
+                if (!found) continue;
+                Connection& conn = *found;
+
+                conn.send_inflight = false;
+                conn.frames_inflight = 0;
+                reactor.stats->add(STAT_SENDS);
+
+                if (res < 0) {
+                    reactor.stats->add(res == -EAGAIN ? STAT_SEND_EAGAIN : STAT_SEND_ERRORS);
+                    conn.inflight.clear();
+                    conn.inflight_off = 0;
+                    conn.out.clear();
+                    releaseFrames(conn);
+                    if (!conn.closing) {
+                        conn.closing = true;
+                        // Kết thúc multishot recv, CQE cuối của nó sẽ đóng kết nối
+                        shutdown(fd, SHUT_RDWR);
+                    } else {
+                        finish(fd);
+                    }
+                    continue;
+                }
+
+                // Phần đã gửi: trước hết là inflight, phần còn lại thuộc về các frame
+                size_t from_inflight = conn.inflight_head;
+                if ((size_t)res < from_inflight) from_inflight = res;
+                conn.inflight_off += from_inflight;
+                consumeFrames(conn, res - from_inflight);
+                if (res > 0) {
+                    conn.last_activity_ns = nowNs();
+                    reactor.stats->add(STAT_BYTES_OUT, res);
+                }
+                if (conn.inflight_off == conn.inflight.size() && conn.out.empty()) responseSent(conn);
+
+                if (conn.closing) finish(fd);
+                else flush(conn);
+            }
+        }
+        logSummary(reactor);
+    }
+}
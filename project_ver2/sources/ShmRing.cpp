@@ -0,0 +1,236 @@
+#include "ShmRing.h"
+
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace {
+
+const uint32_t SHM_MAGIC = 0x5A54524Eu;     // "ZTRN"
+const uint32_t SHM_VERSION = 1;
+const int SLOT_WORDS = 2 + CH_COUNT;        // cùng cách đóng gói với payload của Sampler
+const int SPIN_ITERATIONS = 2000;
+
+std::string shmPath(const std::string& name) {
+    return (name.empty() || name[0] == '/') ? name : "/" + name;
+}
+
+// Vùng nhớ chung giữa các process nên không dùng FUTEX_PRIVATE_FLAG
+int futexWait(std::atomic<uint32_t>* word, uint32_t expected, const struct timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+int futexWake(std::atomic<uint32_t>* word) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+} // namespace
+
+struct ShmRingHeader {
+    std::atomic<uint32_t> magic;    // ghi sau cùng, reader chỉ dùng ring khi đã khớp
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slot_words;
+    alignas(64) std::atomic<uint64_t> head;       // số mẫu đã công bố
+    std::atomic<uint32_t> futex;                  // tăng sau mỗi mẫu, reader ngủ trên word này
+    std::atomic<uint32_t> waiters;                // số reader đang (sắp) FUTEX_WAIT
+};
+
+// seq = 2*index + 1 khi writer đang ghi, 2*index + 2 khi mẫu index đã ghi xong
+struct alignas(64) ShmRingSlot {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> words[SLOT_WORDS];
+};
+
+ShmRingWriter::ShmRingWriter(const std::string& name, unsigned slots)
+    : name(shmPath(name)), capacity(1), mapping(MAP_FAILED), mapping_size(0), header(NULL), slots(NULL) {
+    while (capacity < slots) capacity <<= 1;
+}
+
+ShmRingWriter::~ShmRingWriter() {
+    if (mapping != MAP_FAILED) {
+        munmap(mapping, mapping_size);
+        shm_unlink(name.c_str());
+    }
+}
+
+bool ShmRingWriter::open() {
+    // Tạo mới mỗi lần khởi động, reader của lần chạy trước phải mở lại
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        perror("shm_open failed");
+        return false;
+    }
+
+    mapping_size = sizeof(ShmRingHeader) + (size_t)capacity * sizeof(ShmRingSlot);
+    if (ftruncate(fd, mapping_size) < 0) {
+        perror("ftruncate failed");
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+    mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror("mmap failed");
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // ftruncate đã điền 0: mọi seq = 0 nghĩa là slot chưa có mẫu
+    header = static_cast<ShmRingHeader*>(mapping);
+    slots = reinterpret_cast<ShmRingSlot*>(header + 1);
+    header->version = SHM_VERSION;
+    header->capacity = capacity;
+    header->slot_words = SLOT_WORDS;
+    header->magic.store(SHM_MAGIC, std::memory_order_release);
+    return true;
+}
+
+void ShmRingWriter::onSample(const SampleFrame& frame) {
+    if (!header) return;
+
+    uint64_t index = header->head.load(std::memory_order_relaxed);
+    ShmRingSlot& slot = slots[index & (capacity - 1)];
+
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.words[0].store(frame.sequence | ((uint64_t)frame.channel_mask << 32), std::memory_order_relaxed);
+    slot.words[1].store(frame.timestamp_us, std::memory_order_relaxed);
+    for (int ch = 0; ch < CH_COUNT; ++ch) {
+        uint64_t bits;
+        memcpy(&bits, &frame.values[ch], sizeof(bits));
+        slot.words[2 + ch].store(bits, std::memory_order_relaxed);
+    }
+
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+    header->head.store(index + 1, std::memory_order_release);
+
+    // Không có reader nào ngủ thì không có syscall
+    header->futex.fetch_add(1);
+    if (header->waiters.load() != 0) futexWake(&header->futex);
+}
+
+uint64_t ShmRingWriter::published() const {
+    return header ? header->head.load(std::memory_order_relaxed) : 0;
+}
+
+ShmRingReader::ShmRingReader(const std::string& name)
+    : name(shmPath(name)), mapping(MAP_FAILED), mapping_size(0), header(NULL), slots(NULL), mask(0),
+      next(0), frames_received(0), frames_lost(0), overrun_count(0) {}
+
+ShmRingReader::~ShmRingReader() {
+    if (mapping != MAP_FAILED) munmap(mapping, mapping_size);
+}
+
+bool ShmRingReader::open() {
+    // Cần quyền ghi để đăng ký vào header->waiters trước khi ngủ
+    int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("shm_open failed");
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(ShmRingHeader)) {
+        fprintf(stderr, "Shared memory ring %s is not initialized\n", name.c_str());
+        close(fd);
+        return false;
+    }
+    mapping_size = st.st_size;
+    mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        perror("mmap failed");
+        return false;
+    }
+
+    header = static_cast<ShmRingHeader*>(mapping);
+    if (header->magic.load(std::memory_order_acquire) != SHM_MAGIC || header->version != SHM_VERSION ||
+        header->slot_words != SLOT_WORDS || (header->capacity & (header->capacity - 1)) != 0 ||
+        sizeof(ShmRingHeader) + (size_t)header->capacity * sizeof(ShmRingSlot) > mapping_size) {
+        fprintf(stderr, "Shared memory ring %s has an incompatible layout\n", name.c_str());
+        return false;
+    }
+    slots = reinterpret_cast<ShmRingSlot*>(header + 1);
+    mask = header->capacity - 1;
+
+    uint64_t head = header->head.load(std::memory_order_acquire);
+    next = head > 0 ? head - 1 : 0;
+    return true;
+}
+
+void ShmRingReader::skipTo(uint64_t index) {
+    frames_lost += index - next;
+    ++overrun_count;
+    next = index;
+}
+
+int ShmRingReader::read(SampleFrame& frame) {
+    uint64_t words[SLOT_WORDS];
+    while (true) {
+        uint64_t head = header->head.load(std::memory_order_acquire);
+        if (next >= head) return 0;
+
+        // Writer đã đi trước hơn một vòng: các mẫu cũ đã bị ghi đè
+        uint64_t capacity = mask + 1;
+        if (head - next > capacity) {
+            skipTo(head - capacity);
+            continue;
+        }
+
+        const ShmRingSlot& slot = slots[next & mask];
+        uint64_t before = slot.seq.load(std::memory_order_acquire);
+        for (int i = 0; i < SLOT_WORDS; ++i) words[i] = slot.words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.seq.load(std::memory_order_relaxed);
+
+        // Slot đã bị ghi đè (hoặc đang ghi) trong lúc đọc: đọc lại từ vị trí mới
+        if (before != 2 * next + 2 || after != before) {
+            uint64_t latest = header->head.load(std::memory_order_acquire);
+            skipTo(latest > capacity ? latest - capacity + 1 : next + 1);
+            continue;
+        }
+        break;
+    }
+
+    frame.sequence = (uint32_t)words[0];
+    frame.channel_mask = (ChannelMask)(words[0] >> 32);
+    frame.timestamp_us = words[1];
+    for (int ch = 0; ch < CH_COUNT; ++ch) memcpy(&frame.values[ch], &words[2 + ch], sizeof(double));
+
+    ++next;
+    ++frames_received;
+    return 1;
+}
+
+bool ShmRingReader::wait(int timeout_ms) {
+    for (int i = 0; i < SPIN_ITERATIONS; ++i) {
+        if (header->head.load(std::memory_order_acquire) > next) return true;
+    }
+
+    // Đăng ký waiters trước khi đọc futex: writer tăng futex trước khi xem waiters,
+    // nên hoặc nó thấy reader này và đánh thức, hoặc FUTEX_WAIT trả về ngay
+    header->waiters.fetch_add(1);
+    uint32_t value = header->futex.load();
+    bool ready = header->head.load(std::memory_order_acquire) > next;
+    if (!ready) {
+        struct timespec timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        futexWait(&header->futex, value, &timeout);
+        ready = header->head.load(std::memory_order_acquire) > next;
+    }
+    header->waiters.fetch_sub(1);
+    return ready;
+}
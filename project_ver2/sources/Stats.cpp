@@ -0,0 +1,108 @@
+#include "Stats.h"
+
+#include <cstdio>
+#include <cstring>
+
+const char* const STAT_COUNTER_NAMES[STAT_COUNTERS] = {
+    "accepted", "rejected", "requests", "bytes_in", "bytes_out", "sends", "send_eagain", "send_errors",
+    "frames_dropped", "connections", "queued_frames", "queue_high_water",
+};
+
+LatencyHistogram::LatencyHistogram() : max_ns(0) {
+    for (int i = 0; i < BUCKETS; ++i) counts[i].store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketOf(uint64_t ns) {
+    if (ns < (1u << SUB_BITS)) return (int)ns;
+    if (ns >= (1ull << MAX_BITS)) return BUCKETS - 1;
+    int exponent = 63 - __builtin_clzll(ns);
+    int shift = exponent - (SUB_BITS - 1);
+    return (shift + 1) * HALF + (int)((ns >> shift) - HALF);
+}
+
+uint64_t LatencyHistogram::bucketUpper(int bucket) {
+    if (bucket < (1 << SUB_BITS)) return (uint64_t)bucket;
+    int shift = bucket / HALF - 1;
+    uint64_t mantissa = (uint64_t)(bucket % HALF + HALF);
+    return ((mantissa + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    std::atomic<uint64_t>& count = counts[bucketOf(ns)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (ns > max_ns.load(std::memory_order_relaxed)) max_ns.store(ns, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::addTo(uint64_t* out) const {
+    for (int i = 0; i < BUCKETS; ++i) out[i] += counts[i].load(std::memory_order_relaxed);
+}
+
+ThreadStats::ThreadStats() {
+    for (int i = 0; i < STAT_COUNTERS; ++i) values[i].store(0, std::memory_order_relaxed);
+}
+
+LatencySnapshot::LatencySnapshot() : max_ns(0) {
+    memset(counts, 0, sizeof(counts));
+}
+
+void LatencySnapshot::add(const LatencyHistogram& histogram) {
+    histogram.addTo(counts);
+    if (histogram.max() > max_ns) max_ns = histogram.max();
+}
+
+uint64_t LatencySnapshot::count() const {
+    uint64_t total = 0;
+    for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) total += counts[i];
+    return total;
+}
+
+uint64_t LatencySnapshot::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * total);
+    if (rank >= total) rank = total - 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen > rank) {
+            uint64_t upper = LatencyHistogram::bucketUpper(i);
+            return upper < max_ns ? upper : max_ns;
+        }
+    }
+    return max_ns;
+}
+
+size_t LatencySnapshot::format(char* out, size_t size) const {
+    int n = snprintf(out, size, "count=%llu p50_us=%.1f p90_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f",
+                     (unsigned long long)count(), percentile(0.5) / 1e3, percentile(0.9) / 1e3,
+                     percentile(0.99) / 1e3, percentile(0.999) / 1e3, max_ns / 1e3);
+    if (n < 0) return 0;
+    return (size_t)n < size ? n : size - 1;
+}
+
+StatsSnapshot::StatsSnapshot() {
+    memset(values, 0, sizeof(values));
+}
+
+void StatsSnapshot::add(const ThreadStats& stats) {
+    for (int i = 0; i < STAT_COUNTERS; ++i) {
+        uint64_t value = stats.get((StatCounter)i);
+        if (i == STAT_QUEUE_HIGH_WATER) {
+            if (value > values[i]) values[i] = value;
+        } else {
+            values[i] += value;
+        }
+    }
+    latency.add(stats.latency);
+}
+
+size_t StatsSnapshot::formatCounters(char* out, size_t size) const {
+    size_t used = 0;
+    for (int i = 0; i < STAT_COUNTERS && used < size; ++i) {
+        int n = snprintf(out + used, size - used, "%s%s=%llu", i ? " " : "", STAT_COUNTER_NAMES[i],
+                         (unsigned long long)values[i]);
+        if (n < 0) break;
+        used += n;
+    }
+    return used < size ? used : size - 1;
+}
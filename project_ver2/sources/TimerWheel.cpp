@@ -0,0 +1,140 @@
+#include "TimerWheel.h"
+
+#include <cstring>
+
+TimerWheel::TimerWheel(int64_t tick_ns)
+    : tick_ns(tick_ns > 0 ? tick_ns : 100000), next_tick(0), count(0) {
+    memset(slots, 0, sizeof(slots));
+    memset(occupied, 0, sizeof(occupied));
+}
+
+void TimerWheel::reset(int64_t now_ns) {
+    next_tick = now_ns / tick_ns;
+}
+
+void TimerWheel::schedule(TimerNode* node, int64_t deadline_ns) {
+    cancel(node);
+    node->expires = deadline_ns > 0 ? (deadline_ns + tick_ns - 1) / tick_ns : 0;
+    insert(node);
+    ++count;
+}
+
+void TimerWheel::cancel(TimerNode* node) {
+    if (!node->armed()) return;
+
+    if (node->prev) node->prev->next = node->next;
+    else slots[node->level][node->slot] = node->next;
+    if (node->next) node->next->prev = node->prev;
+    if (!slots[node->level][node->slot]) {
+        occupied[node->level][node->slot / 64] &= ~(1ULL << (node->slot % 64));
+    }
+
+    node->prev = node->next = NULL;
+    node->level = -1;
+    --count;
+}
+
+void TimerWheel::insert(TimerNode* node) {
+    // Đã quá hạn: xử lý ở tick kế tiếp
+    if (node->expires < next_tick) node->expires = next_tick;
+    uint64_t delta = node->expires - next_tick;
+
+    // Tầng cao nhất phủ 2^32 tick; xa hơn thì hết hạn sớm và người dùng tự hẹn lại
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (1ULL << (SLOT_BITS * (level + 1)))) ++level;
+    if (delta >= (1ULL << (SLOT_BITS * LEVELS))) {
+        node->expires = next_tick + (1ULL << (SLOT_BITS * LEVELS)) - 1;
+    }
+
+    int slot = (node->expires >> (SLOT_BITS * level)) & SLOT_MASK;
+    node->level = level;
+    node->slot = slot;
+    node->prev = NULL;
+    node->next = slots[level][slot];
+    if (node->next) node->next->prev = node;
+    slots[level][slot] = node;
+    occupied[level][slot / 64] |= 1ULL << (slot % 64);
+}
+
+void TimerWheel::cascade(int level, int slot) {
+    TimerNode* node = slots[level][slot];
+    slots[level][slot] = NULL;
+    occupied[level][slot / 64] &= ~(1ULL << (slot % 64));
+
+    while (node) {
+        TimerNode* next = node->next;
+        insert(node);       // khoảng cách đã nhỏ hơn: rơi xuống tầng thấp hơn
+        node = next;
+    }
+}
+
+int TimerWheel::nextSlot(const uint64_t* bits, int from) {
+    // Slot khác rỗng đầu tiên tính từ from, vòng lại đầu bitmap; -1 nếu rỗng hết
+    for (int i = 0; i <= SLOTS / 64; ++i) {
+        int word = (from / 64 + i) % (SLOTS / 64);
+        uint64_t value = bits[word];
+        if (i == 0) value &= ~0ULL << (from % 64);
+        else if (i == SLOTS / 64) value &= (from % 64) ? ~(~0ULL << (from % 64)) : 0;
+        if (value) return word * 64 + __builtin_ctzll(value);
+    }
+    return -1;
+}
+
+void TimerWheel::advance(int64_t now_ns, std::vector<TimerNode*>& expired) {
+    uint64_t target = now_ns / tick_ns;
+
+    while (next_tick <= target) {
+        uint64_t tick = next_tick;
+
+        // Đầu mỗi vòng 256 tick: kéo timer của tầng trên xuống
+        if ((tick & SLOT_MASK) == 0) {
+            for (int level = 1; level < LEVELS; ++level) {
+                int slot = (tick >> (SLOT_BITS * level)) & SLOT_MASK;
+                cascade(level, slot);
+                if (slot != 0) break;
+            }
+        }
+
+        int slot = tick & SLOT_MASK;
+        while (TimerNode* node = slots[0][slot]) {
+            slots[0][slot] = node->next;
+            if (node->next) node->next->prev = NULL;
+            node->prev = node->next = NULL;
+            node->level = -1;
+            --count;
+            expired.push_back(node);
+        }
+        occupied[0][slot / 64] &= ~(1ULL << (slot % 64));
+
+        // Bỏ qua các tick rỗng, nhưng không vượt qua ranh giới cascade kế tiếp
+        next_tick = tick + 1;
+        int from = next_tick & SLOT_MASK;
+        if (from != 0) {
+            int found = nextSlot(occupied[0], from);
+            uint64_t skip = found >= from ? (next_tick & ~SLOT_MASK) + found : (next_tick | SLOT_MASK) + 1;
+            next_tick = skip < target + 1 ? skip : target + 1;
+        }
+    }
+}
+
+int64_t TimerWheel::nextDeadline() const {
+    if (count == 0) return 0;
+
+    uint64_t best = UINT64_MAX;
+    int from = next_tick & SLOT_MASK;
+    int found = nextSlot(occupied[0], from);
+    if (found >= 0) {
+        best = found >= from ? (next_tick & ~SLOT_MASK) + found : (next_tick | SLOT_MASK) + 1 + found;
+    }
+
+    // Tầng trên: lần cascade kế tiếp của slot khác rỗng gần nhất
+    for (int level = 1; level < LEVELS; ++level) {
+        int shift = SLOT_BITS * level;
+        uint64_t base = (next_tick + (1ULL << shift) - 1) >> shift;
+        found = nextSlot(occupied[level], base & SLOT_MASK);
+        if (found < 0) continue;
+        uint64_t tick = (base + ((found - base) & SLOT_MASK)) << shift;
+        if (tick < best) best = tick;
+    }
+    return best * tick_ns;
+}
@@ -1,7 +1,72 @@
 #include "Client.h"
+#include <cstdlib>
+#include <getopt.h>
 
-int main() {
-    Client client("192.168.1.3", 8080, INFO);
+static LogLevel parseLogLevel(const std::string& name) {
+    if (name == "off") return OFF;
+    if (name == "debug") return DEBUG;
+    return INFO;
+}
+
+// "239.1.1.1:9000" hoặc "239.1.1.1" (giữ port mặc định)
+static void parseGroup(const std::string& arg, std::string& group, int& port) {
+    size_t colon = arg.find(':');
+    group = arg.substr(0, colon);
+    if (colon != std::string::npos) port = atoi(arg.c_str() + colon + 1);
+}
+
+// "50:10" = cửa sổ 50 mẫu, gửi sau mỗi 10 mẫu; "50" = stride bằng window
+static void parseWindow(const std::string& arg, unsigned& window, unsigned& stride) {
+    size_t colon = arg.find(':');
+    window = (unsigned)atoi(arg.c_str());
+    stride = colon != std::string::npos ? (unsigned)atoi(arg.c_str() + colon + 1) : window;
+}
+
+int main(int argc, char* argv[]) {
+    ClientConfig config;
+    config.log_level = INFO;
+    // Mặc định streaming 600 Hz (SUBSCRIBE); -s 0 để quay về gửi GET_DATA định kỳ
+    config.stream_rate_hz = 600;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:p:s:A:bGl:m:I:S:U:QP:c:f:M")) != -1) {
+        switch (opt) {
+        case 'i': config.server_ip = optarg; break;
+        case 'p': config.server_port = atoi(optarg); break;
+        case 's': config.stream_rate_hz = atoi(optarg); break;
+        case 'A': parseWindow(optarg, config.aggregate_window, config.aggregate_stride); break;
+        case 'b': config.binary = true; break;
+        case 'G': config.gorilla = true; break;
+        case 'P': config.policy = optarg; break;
+        case 'm': parseGroup(optarg, config.multicast_group, config.multicast_port); break;
+        case 'I': config.multicast_interface = optarg; break;
+        case 'S': config.shm_name = optarg; break;
+        case 'U': config.unix_path = optarg; break;
+        case 'Q': config.unix_seqpacket = true; break;
+        case 'l': config.log_level = parseLogLevel(optarg); break;
+        case 'c':
+            if (!parseRealTimeCpus(optarg, config.realtime)) {
+                std::cerr << "Invalid CPU list: " << optarg << std::endl;
+                return -1;
+            }
+            break;
+        case 'f':
+            if (!parseRealTimePriorities(optarg, config.realtime)) {
+                std::cerr << "Invalid SCHED_FIFO priorities: " << optarg << std::endl;
+                return -1;
+            }
+            break;
+        case 'M': config.realtime.lock_memory = true; break;
+        default:
+            std::cerr << "Usage: " << argv[0] << " [-i server_ip] [-p port] [-s stream_rate_hz] [-b | -G]"
+                      << " [-A window[:stride]] [-m group[:port]] [-I multicast_if_ip] [-S shm_name] [-U unix_path [-Q]]"
+                      << " [-P DROP_OLDEST|COALESCE|DISCONNECT] [-c pacing_cpu[,receive_cpu]]"
+                      << " [-f pacing_prio[:receive_prio]] [-M] [-l off|info|debug]" << std::endl;
+            return -1;
+        }
+    }
+
+    Client client(config);
 
     if (!client.connectToServer()) {
         return -1;
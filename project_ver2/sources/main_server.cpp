@@ -1,7 +1,91 @@
 #include "Server.h"
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
 
-int main() {
-    Server server(8080);
+static LogLevel parseLogLevel(const std::string& name) {
+    if (name == "off") return OFF;
+    if (name == "debug") return DEBUG;
+    return INFO;
+}
+
+// "239.1.1.1:9000" hoặc "239.1.1.1" (giữ port mặc định)
+static void parseGroup(const std::string& arg, std::string& group, int& port) {
+    size_t colon = arg.find(':');
+    group = arg.substr(0, colon);
+    if (colon != std::string::npos) port = atoi(arg.c_str() + colon + 1);
+}
+
+int main(int argc, char* argv[]) {
+    ServerConfig config;
+    config.port = 8080;
+    // Mặc định 1 reactor (Z-turn board); trên máy relay x86 dùng -t <số core>
+    config.num_threads = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:t:ul:r:m:i:S:U:QP:T:C:H:R:Z:K:F:X:LD:k:s:c:f:M")) != -1) {
+        switch (opt) {
+        case 'p': config.port = atoi(optarg); break;
+        case 't': config.num_threads = atoi(optarg); break;
+        case 'u': config.use_io_uring = true; break;
+        case 'r': config.sample_rate_hz = atof(optarg); break;
+        case 'm': parseGroup(optarg, config.multicast_group, config.multicast_port); break;
+        case 'i': config.multicast_interface = optarg; break;
+        case 'S': config.shm_name = optarg; break;
+        case 'U': config.unix_path = optarg; break;
+        case 'Q': config.unix_seqpacket = true; break;
+        case 'P':
+            if (!parseSlowConsumerPolicy(optarg, strlen(optarg), config.slow_consumer_policy)) {
+                std::cerr << "Invalid slow consumer policy: " << optarg
+                          << " (DROP_OLDEST, COALESCE or DISCONNECT)" << std::endl;
+                return -1;
+            }
+            break;
+        case 'T': config.idle_timeout_s = atoi(optarg); break;
+        case 'C': config.max_connections = (unsigned)atoi(optarg); break;
+        case 's': config.stats_interval_s = atoi(optarg); break;
+        case 'c':
+            if (!parseRealTimeCpus(optarg, config.realtime)) {
+                std::cerr << "Invalid CPU list: " << optarg << std::endl;
+                return -1;
+            }
+            break;
+        case 'f':
+            if (!parseRealTimePriorities(optarg, config.realtime)) {
+                std::cerr << "Invalid SCHED_FIFO priorities: " << optarg << std::endl;
+                return -1;
+            }
+            break;
+        case 'M': config.realtime.lock_memory = true; break;
+        case 'R': config.recorder_dir = optarg; break;
+        case 'Z': config.recorder_segment_bytes = (size_t)(atof(optarg) * 1024 * 1024); break;
+        case 'K': config.recorder_max_segments = (unsigned)atoi(optarg); break;
+        case 'D': config.sensor_source = optarg; break;
+        case 'k':
+            if (!parseDeviceCalibration(optarg, config.device_calibration)) {
+                std::cerr << "Invalid device calibration: " << optarg << " (TAG=scale[:offset],...)" << std::endl;
+                return -1;
+            }
+            break;
+        case 'F': config.replay_path = optarg; break;
+        case 'X': config.replay_speed = strcmp(optarg, "max") == 0 ? 0.0 : atof(optarg); break;
+        case 'L': config.replay_loop = true; break;
+        case 'H': config.history_bytes = (size_t)(atof(optarg) * 1024 * 1024); break;
+        case 'l': config.log_level = parseLogLevel(optarg); break;
+        default:
+            std::cerr << "Usage: " << argv[0] << " [-p port] [-t reactor_threads] [-u] [-r sample_rate_hz]"
+                      << " [-m group[:port]] [-i multicast_if_ip] [-S shm_name] [-U unix_path [-Q]]"
+                      << " [-P DROP_OLDEST|COALESCE|DISCONNECT] [-T idle_timeout_s (0 = off)] [-C max_connections]"
+                      << " [-s stats_interval_s] [-H history_mb]"
+                      << " [-R recorder_dir [-Z segment_mb] [-K max_segments (>= 2, incl. active and spare)]]"
+                      << " [-D sim|mock|device [-k TAG=scale[:offset],...]] [-F replay_file [-X speed|max] [-L]]"
+                      << " [-c sampler_cpu[,reactor_cpu...]] [-f sampler_prio[:reactor_prio]] [-M]"
+                      << " [-l off|info|debug]" << std::endl;
+            return -1;
+        }
+    }
+
+    Server server(config);
     server.start();
     return 0;
 }
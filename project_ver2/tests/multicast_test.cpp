@@ -0,0 +1,105 @@
+// Kiểm tra MulticastPublisher/MulticastReceiver qua multicast trên loopback:
+// frame đi một vòng encode -> datagram -> decode, sequence bị nhảy được đếm là mất,
+// datagram trùng hoặc đến muộn bị bỏ qua.
+#include "Multicast.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++failures; \
+        } \
+    } while (0)
+
+// ctest coi mã thoát này là "skipped" (môi trường không có multicast trên loopback)
+static const int SKIP = 77;
+
+static const char* GROUP = "239.255.42.99";
+static const char* LOOPBACK = "127.0.0.1";
+
+static SampleFrame makeFrame(uint32_t sequence) {
+    SampleFrame frame;
+    frame.channel_mask = CHANNEL_MASK_ALL;
+    frame.sequence = sequence;
+    frame.timestamp_us = 1000000ull + sequence * 1000ull;
+    for (int ch = 0; ch < CH_COUNT; ++ch) frame.values[ch] = sequence * 10.0 + ch + 0.5;
+    return frame;
+}
+
+// Chờ tối đa timeout_ms cho tới khi nhận được một frame hợp lệ hoặc socket hết dữ liệu
+static int receiveOne(MulticastReceiver& receiver, SampleFrame& frame, int timeout_ms) {
+    while (true) {
+        struct pollfd pfd = { receiver.fd(), POLLIN, 0 };
+        if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+        int result = receiver.receive(frame);
+        if (result != 0) return result;
+    }
+}
+
+int main() {
+    // Port theo pid để các lần chạy song song không nhận nhầm datagram của nhau
+    int port = 20000 + (int)(getpid() % 20000);
+
+    MulticastReceiver receiver(GROUP, port, LOOPBACK);
+    if (!receiver.open()) {
+        fprintf(stderr, "multicast join on %s failed, skipping\n", LOOPBACK);
+        return SKIP;
+    }
+    MulticastPublisher publisher(GROUP, port, 0, LOOPBACK);
+    if (!publisher.open()) {
+        fprintf(stderr, "multicast publisher on %s failed, skipping\n", LOOPBACK);
+        return SKIP;
+    }
+
+    // 1..10 bỏ 4, 5 và 8 (mất 3), sau đó một datagram trùng (10) và một đến muộn (6)
+    const uint32_t sent[] = { 1, 2, 3, 6, 7, 9, 10, 10, 6, 11 };
+    const size_t count = sizeof(sent) / sizeof(sent[0]);
+    for (size_t i = 0; i < count; ++i) publisher.onSample(makeFrame(sent[i]));
+    CHECK(publisher.sent() == count);
+    CHECK(publisher.errors() == 0);
+
+    const uint32_t expected[] = { 1, 2, 3, 6, 7, 9, 10, 11 };
+    const size_t expected_count = sizeof(expected) / sizeof(expected[0]);
+    SampleFrame frame;
+    size_t received = 0;
+    while (received < expected_count && receiveOne(receiver, frame, 1000) == 1) {
+        if (received == 0 && frame.sequence != expected[0]) {
+            fprintf(stderr, "no loopback multicast delivery, skipping\n");
+            return SKIP;
+        }
+        CHECK(frame.sequence == expected[received]);
+        SampleFrame original = makeFrame(expected[received]);
+        CHECK(frame.channel_mask == original.channel_mask);
+        CHECK(frame.timestamp_us == original.timestamp_us);
+        for (int ch = 0; ch < CH_COUNT; ++ch) {
+            // Giá trị đi trên dây là float
+            CHECK(frame.values[ch] == (double)(float)original.values[ch]);
+        }
+        ++received;
+    }
+    if (received == 0) {
+        fprintf(stderr, "no loopback multicast delivery, skipping\n");
+        return SKIP;
+    }
+
+    CHECK(received == expected_count);
+    CHECK(receiver.received() == expected_count);
+    CHECK(receiver.lost() == 3);
+    // Không còn gì khác trong socket
+    CHECK(receiveOne(receiver, frame, 100) == 0);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return EXIT_FAILURE;
+    }
+    printf("multicast loopback: %zu frames received, %llu lost\n", received,
+           (unsigned long long)receiver.lost());
+    return EXIT_SUCCESS;
+}